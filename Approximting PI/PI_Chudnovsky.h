@@ -0,0 +1,909 @@
+#ifndef OPENMP_C_TUTORIAL_PI_CHUDNOVSKY_H
+#define OPENMP_C_TUTORIAL_PI_CHUDNOVSKY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <omp.h>
+
+/**
+ * Computing the decimal digits of π with the Chudnovsky series and binary splitting. Unlike the midpoint-rule
+ * estimations in PI_Numerical_Integration.h, whose accuracy ends at the precision of a double, this computes as many
+ * correct digits as memory allows (each term of the series adds about 14 digits), which makes it a good multi-core
+ * stress benchmark.
+ *
+ *   1/π = 12 Σ (-1)^k (6k)! (13591409 + 545140134 k) / ((3k)! (k!)^3 640320^(3k + 3/2))
+ *
+ * Binary splitting turns the sum of N terms into three big integers P, Q and T, computed recursively over halves of
+ * the range of terms; the two halves are independent and run as OpenMP tasks. Then
+ *
+ *   π = 426880 √10005 Q / T
+ *
+ * is evaluated in fixed point, with Newton iterations for 1/√10005 and 1/T.
+ *
+ * Big integers are stored in base 10^4 so that the result can be printed without a radix conversion. Large products
+ * use a number theoretic transform over two primes of the form c·2^k + 1, recombined with the Chinese remainder
+ * theorem; the butterflies of each transform are split with taskloop, so the large multiplications at the top of the
+ * recursion use every thread too. One transform holds up to 2^26 limbs, so a product of up to about 268 million digits
+ * is computed in a single pass; larger operands are multiplied in chunks.
+ *
+ * Digits are written as soon as they are final. That is only possible in the last multiplication, since every digit
+ * depends on the whole series, but there about half of them are written while the other half is still being computed.
+ *
+ * The initial approximations of the Newton iterations use sqrt() and pow(), so programs that include this header link
+ * with -lm.
+ */
+
+#define CHUDNOVSKY_BASE 10000u
+#define CHUDNOVSKY_BASE_DIGITS 4
+#define CHUDNOVSKY_DIGITS_PER_TERM 14.181647462725477
+#define CHUDNOVSKY_GUARD_LIMBS 4
+#define CHUDNOVSKY_SCHOOLBOOK_LIMIT 48          // operands shorter than this are multiplied by the schoolbook method
+#define CHUDNOVSKY_SEQUENTIAL_TERMS 64          // ranges of terms shorter than this are split without creating tasks
+#define CHUDNOVSKY_TASKLOOP_MIN (1 << 15)       // transforms shorter than this are not split into tasks
+#define NTT_MAX_LENGTH (1u << 26)
+
+// Global variable to measure the runtime
+// --------------------------------------
+double PI_CHUDNOVSKY_RUNTIME[1];
+
+// Big integers
+// ------------
+typedef struct {
+    uint32_t* limb;         // little-endian digits in base CHUDNOVSKY_BASE
+    size_t length;          // no leading zero limbs; 0 means the value 0
+    size_t capacity;
+    int negative;
+} bigint;
+
+void bigint_init(bigint* x){
+    x->limb = NULL;
+    x->length = 0;
+    x->capacity = 0;
+    x->negative = 0;
+}
+
+void bigint_free(bigint* x){
+    free(x->limb);
+    bigint_init(x);
+}
+
+static void bigint_reserve(bigint* x, size_t capacity){
+    if (capacity <= x->capacity)
+        return;
+    x->limb = (uint32_t*)realloc(x->limb, capacity * sizeof(uint32_t));
+    if (x->limb == NULL) {
+        fprintf(stderr, "bigint: out of memory (%zu limbs)\n", capacity);
+        exit(EXIT_FAILURE);
+    }
+    x->capacity = capacity;
+}
+
+static void bigint_normalize(bigint* x){
+    while (x->length > 0 && x->limb[x->length - 1] == 0)
+        x->length--;
+    if (x->length == 0)
+        x->negative = 0;
+}
+
+void bigint_set_u64(bigint* x, uint64_t v){
+    bigint_reserve(x, 5);
+    x->length = 0;
+    x->negative = 0;
+    while (v > 0) {
+        x->limb[x->length++] = (uint32_t)(v % CHUDNOVSKY_BASE);
+        v /= CHUDNOVSKY_BASE;
+    }
+}
+
+void bigint_copy(bigint* to, const bigint* from){
+    bigint_reserve(to, from->length);
+    if (from->length > 0)
+        memcpy(to->limb, from->limb, from->length * sizeof(uint32_t));
+    to->length = from->length;
+    to->negative = from->negative;
+}
+
+/// Exchanges the contents of two big integers without copying their limbs
+void bigint_swap(bigint* a, bigint* b){
+    bigint t = *a;
+    *a = *b;
+    *b = t;
+}
+
+/// x = x * m
+void bigint_mul_small(bigint* x, uint32_t m){
+    uint64_t carry = 0;
+    for (size_t i = 0; i < x->length; i++) {
+        uint64_t v = (uint64_t)x->limb[i] * m + carry;
+        x->limb[i] = (uint32_t)(v % CHUDNOVSKY_BASE);
+        carry = v / CHUDNOVSKY_BASE;
+    }
+    while (carry > 0) {
+        bigint_reserve(x, x->length + 1);
+        x->limb[x->length++] = (uint32_t)(carry % CHUDNOVSKY_BASE);
+        carry /= CHUDNOVSKY_BASE;
+    }
+    bigint_normalize(x);
+}
+
+/// x = x / d, rounded toward zero
+void bigint_div_small(bigint* x, uint32_t d){
+    uint64_t remainder = 0;
+    for (size_t i = x->length; i-- > 0;) {
+        uint64_t v = remainder * CHUDNOVSKY_BASE + x->limb[i];
+        x->limb[i] = (uint32_t)(v / d);
+        remainder = v % d;
+    }
+    bigint_normalize(x);
+}
+
+/// x = x * CHUDNOVSKY_BASE^k
+void bigint_shift_left(bigint* x, size_t k){
+    if (x->length == 0 || k == 0)
+        return;
+    bigint_reserve(x, x->length + k);
+    memmove(x->limb + k, x->limb, x->length * sizeof(uint32_t));
+    memset(x->limb, 0, k * sizeof(uint32_t));
+    x->length += k;
+}
+
+/// x = x / CHUDNOVSKY_BASE^k, rounded toward zero
+void bigint_shift_right(bigint* x, size_t k){
+    if (k >= x->length) {
+        x->length = 0;
+        x->negative = 0;
+        return;
+    }
+    memmove(x->limb, x->limb + k, (x->length - k) * sizeof(uint32_t));
+    x->length -= k;
+}
+
+static int bigint_compare_magnitude(const bigint* a, const bigint* b){
+    if (a->length != b->length)
+        return a->length < b->length ? -1 : 1;
+    for (size_t i = a->length; i-- > 0;)
+        if (a->limb[i] != b->limb[i])
+            return a->limb[i] < b->limb[i] ? -1 : 1;
+    return 0;
+}
+
+/// r = a + b, where a and b are given as magnitudes and signs. r may alias a or b.
+static void bigint_add_signed(bigint* r, const bigint* a, int a_negative, const bigint* b, int b_negative){
+    if (a_negative == b_negative) {
+        size_t length = (a->length > b->length ? a->length : b->length) + 1;
+        bigint_reserve(r, length);
+        uint32_t carry = 0;
+        for (size_t i = 0; i < length - 1; i++) {
+            uint32_t v = carry + (i < a->length ? a->limb[i] : 0) + (i < b->length ? b->limb[i] : 0);
+            carry = v >= CHUDNOVSKY_BASE;
+            r->limb[i] = carry ? v - CHUDNOVSKY_BASE : v;
+        }
+        r->limb[length - 1] = carry;
+        r->length = length;
+        r->negative = a_negative;
+    } else {
+        // Subtract the smaller magnitude from the larger one
+        int a_larger = bigint_compare_magnitude(a, b) >= 0;
+        const bigint* large = a_larger ? a : b;
+        const bigint* small = a_larger ? b : a;
+        int negative = a_larger ? a_negative : b_negative;
+        size_t small_length = small->length;
+        bigint_reserve(r, large->length);
+        int32_t borrow = 0;
+        for (size_t i = 0; i < large->length; i++) {
+            int32_t v = (int32_t)large->limb[i] - borrow - (int32_t)(i < small_length ? small->limb[i] : 0);
+            borrow = v < 0;
+            r->limb[i] = (uint32_t)(borrow ? v + (int32_t)CHUDNOVSKY_BASE : v);
+        }
+        r->length = large->length;
+        r->negative = negative;
+    }
+    bigint_normalize(r);
+}
+
+void bigint_add(bigint* r, const bigint* a, const bigint* b){
+    bigint_add_signed(r, a, a->negative, b, b->negative);
+}
+
+void bigint_sub(bigint* r, const bigint* a, const bigint* b){
+    bigint_add_signed(r, a, a->negative, b, !b->negative);
+}
+
+// Number theoretic transform
+// --------------------------
+// Two NTT-friendly primes: 469762049 = 7·2^26 + 1 and 2013265921 = 15·2^27 + 1. Both support transforms of length 2^26,
+// and their product (~9.5·10^17) exceeds the largest coefficient of a convolution of 2^26 limbs (2^26 · 10^8).
+static const uint32_t NTT_PRIME[2] = {469762049u, 2013265921u};
+static const uint32_t NTT_ROOT[2] = {3u, 31u};
+#define NTT_PRIME_0_INVERSE_MOD_1 1312999515ull
+
+static inline uint32_t ntt_mul(uint32_t a, uint32_t b, uint32_t p){
+    return (uint32_t)((uint64_t)a * b % p);
+}
+
+static uint32_t ntt_pow(uint32_t a, uint64_t e, uint32_t p){
+    uint32_t r = 1;
+    while (e > 0) {
+        if (e & 1)
+            r = ntt_mul(r, a, p);
+        a = ntt_mul(a, a, p);
+        e >>= 1;
+    }
+    return r;
+}
+
+/**
+ * Montgomery arithmetic modulo p with R = 2^32, which replaces the 64-bit division of ntt_mul() in the butterflies by
+ * two multiplications. Twiddle factors are kept in Montgomery form (x·R mod p), so multiplying a plain residue by one
+ * with ntt_montgomery_mul() returns a plain residue again.
+ */
+typedef struct {
+    uint32_t p;
+    uint32_t p_inverse_negated;         // -p^-1 mod 2^32
+    uint32_t r_squared;                 // R^2 mod p
+} ntt_modulus;
+
+static ntt_modulus ntt_modulus_create(uint32_t p){
+    ntt_modulus m;
+    m.p = p;
+    uint32_t inverse = p;               // Newton iteration, every step doubles the number of correct bits
+    for (int i = 0; i < 4; i++)
+        inverse *= 2u - p * inverse;
+    m.p_inverse_negated = 0u - inverse;
+    uint64_t r = (1ull << 32) % p;
+    m.r_squared = (uint32_t)(r * r % p);
+    return m;
+}
+
+/// Returns a·b·R^-1 mod p for a·b < p·2^32
+static inline uint32_t ntt_montgomery_mul(uint32_t a, uint32_t b, const ntt_modulus* m){
+    uint64_t t = (uint64_t)a * b;
+    uint32_t q = (uint32_t)t * m->p_inverse_negated;
+    uint32_t r = (uint32_t)((t + (uint64_t)q * m->p) >> 32);
+    return r >= m->p ? r - m->p : r;
+}
+
+static inline uint32_t ntt_to_montgomery(uint32_t a, const ntt_modulus* m){
+    return ntt_montgomery_mul(a, m->r_squared, m);
+}
+
+/// Butterflies k in [begin, end) of the stage whose blocks are 2^(shift + 1) long; stage_roots[j] = w_stage^j
+static void ntt_butterflies(uint32_t* a, const uint32_t* stage_roots, int shift, size_t begin, size_t end,
+                            ntt_modulus m){
+    size_t half = (size_t)1 << shift;
+    for (size_t k = begin; k < end; k++) {
+        size_t j = k & (half - 1);
+        size_t i = ((k >> shift) << (shift + 1)) + j;
+        uint32_t u = a[i];
+        uint32_t v = ntt_montgomery_mul(a[i + half], stage_roots[j], &m);
+        uint32_t sum = u + v;
+        a[i] = sum >= m.p ? sum - m.p : sum;
+        a[i + half] = u >= v ? u - v : u + m.p - v;
+    }
+}
+
+/**
+ * In-place iterative NTT of length n (a power of two) modulo p. The twiddle factors of the stage with blocks of
+ * length 2·half are stored contiguously at roots[half, 2·half), so every stage reads its table sequentially. Each
+ * stage is a flat loop over the n / 2 butterflies, split with taskloop when the transform is long; short transforms
+ * call the loop directly, since even an undeferred task costs more than their butterflies. The inverse transform also
+ * multiplies every output by scale.
+ */
+static void ntt(uint32_t* a, size_t n, uint32_t p, uint32_t g, int inverse, uint32_t scale){
+    ntt_modulus m = ntt_modulus_create(p);
+    int parallel = n >= CHUDNOVSKY_TASKLOOP_MIN;
+    size_t chunk = 4096;
+
+    // Bit-reversal permutation
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            uint32_t t = a[i];
+            a[i] = a[j];
+            a[j] = t;
+        }
+    }
+
+    size_t half_n = n / 2;
+    uint32_t* roots = (uint32_t*)malloc((n > 1 ? n : 2) * sizeof(uint32_t));
+    uint32_t w = ntt_pow(g, (p - 1) / n, p);
+    if (inverse)
+        w = ntt_pow(w, p - 2, p);
+    uint32_t w_montgomery = ntt_to_montgomery(w, &m);
+
+    // The last stage uses the powers of w, every earlier stage every other power of the next one
+    #pragma omp taskloop if(parallel) default(none) shared(roots, half_n, chunk, w, w_montgomery, p, m)
+    for (size_t start = 0; start < half_n; start += chunk) {
+        uint32_t r = ntt_to_montgomery(ntt_pow(w, start, p), &m);
+        size_t end = start + chunk < half_n ? start + chunk : half_n;
+        for (size_t j = start; j < end; j++) {
+            roots[half_n + j] = r;
+            r = ntt_montgomery_mul(r, w_montgomery, &m);
+        }
+    }
+    for (size_t half = half_n / 2; half >= 1; half /= 2)
+        for (size_t j = 0; j < half; j++)
+            roots[half + j] = roots[2 * half + 2 * j];
+
+    int shift = 0;
+    for (size_t half = 1; half <= half_n; half <<= 1, shift++) {
+        if (!parallel) {
+            ntt_butterflies(a, roots + half, shift, 0, half_n, m);
+            continue;
+        }
+        #pragma omp taskloop default(none) shared(a, roots, half_n, half, shift, chunk, m)
+        for (size_t start = 0; start < half_n; start += chunk)
+            ntt_butterflies(a, roots + half, shift, start, start + chunk < half_n ? start + chunk : half_n, m);
+    }
+    free(roots);
+
+    if (inverse) {
+        uint32_t factor = ntt_to_montgomery(ntt_mul(ntt_pow((uint32_t)(n % p), p - 2, p), scale, p), &m);
+        #pragma omp taskloop if(parallel) grainsize(16384) default(none) shared(a, n, factor, m)
+        for (size_t i = 0; i < n; i++)
+            a[i] = ntt_montgomery_mul(a[i], factor, &m);
+    }
+}
+
+/**
+ * Adds the product of a[0, la) and b[0, lb) (limbs, not normalized) to accumulator[0, la + lb - 1), using two NTTs
+ * and the Chinese remainder theorem. la + lb - 1 must not exceed NTT_MAX_LENGTH.
+ */
+static void ntt_multiply_accumulate(const uint32_t* a, size_t la, const uint32_t* b, size_t lb, uint64_t* accumulator){
+    size_t result_length = la + lb - 1;
+    size_t n = 1;
+    while (n < result_length)
+        n <<= 1;
+    int square = a == b && la == lb;
+
+    uint32_t* residue[2];
+    for (int q = 0; q < 2; q++) {
+        uint32_t p = NTT_PRIME[q];
+        ntt_modulus m = ntt_modulus_create(p);
+        uint32_t* fa = (uint32_t*)calloc(n, sizeof(uint32_t));
+        uint32_t* fb = square ? fa : (uint32_t*)calloc(n, sizeof(uint32_t));
+        memcpy(fa, a, la * sizeof(uint32_t));
+        if (!square)
+            memcpy(fb, b, lb * sizeof(uint32_t));
+
+        ntt(fa, n, p, NTT_ROOT[q], 0, 1);
+        if (!square)
+            ntt(fb, n, p, NTT_ROOT[q], 0, 1);
+
+        // The pointwise Montgomery products carry a factor R^-1, which the inverse transform scales away
+        int parallel = n >= CHUDNOVSKY_TASKLOOP_MIN;
+        #pragma omp taskloop if(parallel) grainsize(16384) default(none) shared(fa, fb, n, m)
+        for (size_t i = 0; i < n; i++)
+            fa[i] = ntt_montgomery_mul(fa[i], fb[i], &m);
+
+        ntt(fa, n, p, NTT_ROOT[q], 1, (uint32_t)((1ull << 32) % p));
+        if (!square)
+            free(fb);
+        residue[q] = fa;
+    }
+
+    // x = r0 + p0 · ((r1 - r0) · p0^-1 mod p1) is the exact coefficient, since it is below p0 · p1
+    for (size_t i = 0; i < result_length; i++) {
+        uint64_t r0 = residue[0][i];
+        uint64_t r1 = residue[1][i];
+        uint64_t p1 = NTT_PRIME[1];
+        uint64_t difference = (r1 + p1 - r0 % p1) % p1;
+        uint64_t t = difference * NTT_PRIME_0_INVERSE_MOD_1 % p1;
+        accumulator[i] += r0 + (uint64_t)NTT_PRIME[0] * t;
+    }
+    free(residue[0]);
+    free(residue[1]);
+}
+
+/// Propagates the carries of an accumulator of length n into the limbs of r
+static void bigint_from_accumulator(bigint* r, uint64_t* accumulator, size_t n){
+    bigint_reserve(r, n + 6);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t v = accumulator[i] + carry;
+        r->limb[i] = (uint32_t)(v % CHUDNOVSKY_BASE);
+        carry = v / CHUDNOVSKY_BASE;
+    }
+    r->length = n;
+    while (carry > 0) {
+        r->limb[r->length++] = (uint32_t)(carry % CHUDNOVSKY_BASE);
+        carry /= CHUDNOVSKY_BASE;
+    }
+}
+
+/**
+ * r = a * b. r may alias a or b.
+ */
+void bigint_mul(bigint* r, const bigint* a, const bigint* b){
+    if (a->length == 0 || b->length == 0) {
+        r->length = 0;
+        r->negative = 0;
+        return;
+    }
+
+    size_t la = a->length, lb = b->length;
+    size_t n = la + lb;
+    uint64_t* accumulator = (uint64_t*)calloc(n, sizeof(uint64_t));
+
+    if (la < CHUDNOVSKY_SCHOOLBOOK_LIMIT || lb < CHUDNOVSKY_SCHOOLBOOK_LIMIT) {
+        // Every product is below 10^8, so a row of sums cannot overflow before the carries are propagated
+        for (size_t i = 0; i < la; i++) {
+            uint64_t ai = a->limb[i];
+            for (size_t j = 0; j < lb; j++)
+                accumulator[i + j] += ai * b->limb[j];
+        }
+    } else {
+        // Split the operands so that every partial product fits in one transform
+        size_t chunk = NTT_MAX_LENGTH / 2;
+        for (size_t i = 0; i < la; i += chunk) {
+            size_t ca = la - i < chunk ? la - i : chunk;
+            for (size_t j = 0; j < lb; j += chunk) {
+                size_t cb = lb - j < chunk ? lb - j : chunk;
+                ntt_multiply_accumulate(a->limb + i, ca, b->limb + j, cb, accumulator + i + j);
+            }
+        }
+    }
+
+    int negative = a->negative != b->negative;
+    bigint product;
+    bigint_init(&product);
+    bigint_from_accumulator(&product, accumulator, n);
+    product.negative = negative;
+    free(accumulator);
+
+    bigint_normalize(&product);
+    bigint_swap(r, &product);
+    bigint_free(&product);
+}
+
+// Binary splitting
+// ----------------
+/**
+ * Computes P, Q and T of the terms [a, b) of the series. P is only needed by the left half of a split, so the caller
+ * says whether it wants it.
+ */
+static void chudnovsky_split(long a, long b, bigint* P, bigint* Q, bigint* T, int need_P, int task_depth){
+    if (b - a == 1) {
+        bigint p;
+        bigint_init(&p);
+        if (a == 0) {
+            bigint_set_u64(&p, 1);
+            bigint_set_u64(Q, 1);
+        } else {
+            // P = (6a - 5)(2a - 1)(6a - 1), Q = a^3 · 640320^3 / 24 = a^3 · 26680 · 640320 · 640320
+            bigint_set_u64(&p, (uint64_t)(6 * a - 5));
+            bigint_mul_small(&p, (uint32_t)(2 * a - 1));
+            bigint_mul_small(&p, (uint32_t)(6 * a - 1));
+            bigint_set_u64(Q, (uint64_t)a);
+            bigint_mul_small(Q, (uint32_t)a);
+            bigint_mul_small(Q, (uint32_t)a);
+            bigint_mul_small(Q, 26680u);
+            bigint_mul_small(Q, 640320u);
+            bigint_mul_small(Q, 640320u);
+        }
+        bigint factor;
+        bigint_init(&factor);
+        bigint_set_u64(&factor, 13591409ull + 545140134ull * (uint64_t)a);
+        bigint_mul(T, &p, &factor);
+        if (a & 1)
+            T->negative = T->length > 0;
+        if (need_P)
+            bigint_swap(P, &p);
+        bigint_free(&p);
+        bigint_free(&factor);
+        return;
+    }
+
+    long m = (a + b) / 2;
+    bigint P1, Q1, T1, P2, Q2, T2;
+    bigint_init(&P1); bigint_init(&Q1); bigint_init(&T1);
+    bigint_init(&P2); bigint_init(&Q2); bigint_init(&T2);
+
+    if (task_depth > 0 && b - a >= CHUDNOVSKY_SEQUENTIAL_TERMS) {
+        #pragma omp task default(none) shared(P1, Q1, T1) firstprivate(a, m, task_depth)
+        chudnovsky_split(a, m, &P1, &Q1, &T1, 1, task_depth - 1);
+        chudnovsky_split(m, b, &P2, &Q2, &T2, need_P, task_depth - 1);
+        #pragma omp taskwait
+    } else {
+        chudnovsky_split(a, m, &P1, &Q1, &T1, 1, 0);
+        chudnovsky_split(m, b, &P2, &Q2, &T2, need_P, 0);
+    }
+
+    // T = T1 · Q2 + P1 · T2, Q = Q1 · Q2, P = P1 · P2; the products are independent
+    #pragma omp taskgroup
+    {
+        #pragma omp task default(none) shared(T1, Q2) if(task_depth > 0)
+        bigint_mul(&T1, &T1, &Q2);
+        #pragma omp task default(none) shared(P1, T2) if(task_depth > 0)
+        bigint_mul(&T2, &P1, &T2);
+        #pragma omp task default(none) shared(Q, Q1, Q2) if(task_depth > 0)
+        bigint_mul(Q, &Q1, &Q2);
+        if (need_P) {
+            #pragma omp task default(none) shared(P, P1, P2) if(task_depth > 0)
+            bigint_mul(P, &P1, &P2);
+        }
+    }
+    bigint_add(T, &T1, &T2);
+
+    bigint_free(&P1); bigint_free(&Q1); bigint_free(&T1);
+    bigint_free(&P2); bigint_free(&Q2); bigint_free(&T2);
+}
+
+// Fixed point
+// -----------
+/**
+ * The precisions (in limbs) of the Newton iterations that end at precision p: each one a little more than half of the
+ * next, since every iteration doubles the number of correct digits.
+ * @return The number of precisions written, smallest first.
+ */
+static int chudnovsky_precision_ladder(size_t p, size_t start, size_t* ladder){
+    int count = 0;
+    size_t reversed[64];
+    while (p > start && count < 64) {
+        reversed[count++] = p;
+        p = p / 2 + 2;
+    }
+    for (int i = 0; i < count; i++)
+        ladder[i] = reversed[count - 1 - i];
+    return count;
+}
+
+/// Y = floor(CHUDNOVSKY_BASE^p / √N), approximately
+static void chudnovsky_inverse_sqrt(bigint* Y, uint32_t N, size_t p){
+    // 15 correct digits from the FPU, as a number scaled by 10^16 = CHUDNOVSKY_BASE^4
+    size_t current = 4;
+    bigint_set_u64(Y, (uint64_t)(1e16 / sqrt((double)N)));
+
+    size_t ladder[64];
+    int steps = chudnovsky_precision_ladder(p, current, ladder);
+    ladder[steps] = p;              // one more iteration at full precision
+    steps++;
+
+    bigint Y2, E, one;
+    bigint_init(&Y2); bigint_init(&E); bigint_init(&one);
+
+    for (int s = 0; s < steps; s++) {
+        size_t q = ladder[s];
+        bigint_shift_left(Y, q - current);
+        current = q;
+
+        // Y = Y + Y · (1 - N · Y²) / 2
+        bigint_mul(&Y2, Y, Y);
+        bigint_shift_right(&Y2, q);
+        bigint_mul_small(&Y2, N);
+        bigint_set_u64(&one, 1);
+        bigint_shift_left(&one, q);
+        bigint_sub(&E, &one, &Y2);
+        bigint_mul(&E, Y, &E);
+        bigint_shift_right(&E, q);
+        bigint_div_small(&E, 2);
+        bigint_add(Y, Y, &E);
+    }
+
+    bigint_free(&Y2); bigint_free(&E); bigint_free(&one);
+}
+
+/// The top q limbs of T as a fixed-point number in [1/CHUDNOVSKY_BASE, 1), scaled by CHUDNOVSKY_BASE^q
+static void chudnovsky_truncate(bigint* Tq, const bigint* T, size_t q){
+    bigint_copy(Tq, T);
+    if (T->length > q)
+        bigint_shift_right(Tq, T->length - q);
+    else
+        bigint_shift_left(Tq, q - T->length);
+}
+
+/// R = CHUDNOVSKY_BASE^(p + length of T) / T, approximately, for T > 0
+static void chudnovsky_reciprocal(bigint* R, const bigint* T, size_t p){
+    // t = T / CHUDNOVSKY_BASE^length lies in [1/CHUDNOVSKY_BASE, 1); start from 1/t scaled by 10^12 = CHUDNOVSKY_BASE^3
+    double t = 0.0;
+    for (size_t i = 0; i < 4 && i < T->length; i++)
+        t += T->limb[T->length - 1 - i] * pow(CHUDNOVSKY_BASE, -(double)(i + 1));
+    size_t current = 3;
+    bigint_set_u64(R, (uint64_t)(1e12 / t));
+
+    size_t ladder[64];
+    int steps = chudnovsky_precision_ladder(p, current, ladder);
+    ladder[steps] = p;
+    steps++;
+
+    bigint Tq, E, one;
+    bigint_init(&Tq); bigint_init(&E); bigint_init(&one);
+
+    for (int s = 0; s < steps; s++) {
+        size_t q = ladder[s];
+        bigint_shift_left(R, q - current);
+        current = q;
+
+        // R = R + R · (1 - t · R)
+        chudnovsky_truncate(&Tq, T, q + 1);
+        bigint_mul(&E, &Tq, R);
+        bigint_shift_right(&E, q + 1);
+        bigint_set_u64(&one, 1);
+        bigint_shift_left(&one, q);
+        bigint_sub(&E, &one, &E);
+        bigint_mul(&E, R, &E);
+        bigint_shift_right(&E, q);
+        bigint_add(R, R, &E);
+    }
+
+    bigint_free(&Tq); bigint_free(&E); bigint_free(&one);
+}
+
+// Output
+// ------
+/**
+ * Writes "3." followed by the first digits decimals of π, a limb at a time through a 64 KB buffer, so the digits never
+ * have to be held as text all at once. Limbs can be written in several calls, from the most significant down, as they
+ * become final.
+ */
+typedef struct {
+    FILE* out;
+    size_t digits;              // decimals to write
+    size_t written;             // decimals written so far
+    size_t next;                // limb of π · CHUDNOVSKY_BASE^L below the last one written; L + 1 before the "3."
+    size_t used;
+    char buffer[1 << 16];
+} chudnovsky_writer;
+
+static void chudnovsky_writer_init(chudnovsky_writer* w, FILE* out, size_t digits, size_t L){
+    w->out = out;
+    w->digits = digits;
+    w->written = 0;
+    w->next = L + 1;
+    w->used = 0;
+}
+
+/**
+ * Writes limbs w->next - 1 down to end of π · CHUDNOVSKY_BASE^L (limb L is the integer part), reading limb i as limb
+ * i + offset of x.
+ */
+static void chudnovsky_write_limbs(chudnovsky_writer* w, const bigint* x, size_t offset, size_t end, size_t L){
+    if (w->next == L + 1 && end <= L) {
+        uint32_t integer_part = L + offset < x->length ? x->limb[L + offset] : 0;
+        w->used += (size_t)snprintf(w->buffer + w->used, sizeof(w->buffer) - w->used, "%u.", integer_part);
+        w->next = L;
+    }
+    for (; w->next > end && w->written < w->digits; w->next--) {
+        size_t i = w->next - 1 + offset;
+        uint32_t limb = i < x->length ? x->limb[i] : 0;
+        char text[CHUDNOVSKY_BASE_DIGITS];
+        for (int d = CHUDNOVSKY_BASE_DIGITS - 1; d >= 0; d--) {
+            text[d] = (char)('0' + limb % 10);
+            limb /= 10;
+        }
+        for (int d = 0; d < CHUDNOVSKY_BASE_DIGITS && w->written < w->digits; d++, w->written++) {
+            w->buffer[w->used++] = text[d];
+            if (w->used == sizeof(w->buffer)) {
+                fwrite(w->buffer, 1, w->used, w->out);
+                w->used = 0;
+            }
+        }
+    }
+}
+
+static void chudnovsky_writer_finish(chudnovsky_writer* w){
+    w->buffer[w->used++] = '\n';
+    fwrite(w->buffer, 1, w->used, w->out);
+    w->used = 0;
+}
+
+/**
+ * pi = Y · R / CHUDNOVSKY_BASE^L, writing the leading digits while the rest of the product is computed. R is split
+ * into R_hi · B^h + R_lo with h = length of R / 2 (B = CHUDNOVSKY_BASE). Y · R_lo < B^(length of Y + h), so adding it
+ * to Y · R_hi · B^h carries at most 1 into limb (length of Y + h), and that carry only moves further up through limbs
+ * equal to B - 1. Every limb above the first other limb from there up is therefore final as soon as Y · R_hi is known;
+ * a task writes those, about half of the digits, while Y · R_lo is computed.
+ */
+static void chudnovsky_multiply_streaming(bigint* pi, const bigint* Y, const bigint* R, size_t L, chudnovsky_writer* w){
+    size_t h = R->length / 2;
+    bigint R_hi, R_lo, S, S_lo;
+    bigint_init(&R_hi); bigint_init(&R_lo); bigint_init(&S); bigint_init(&S_lo);
+
+    bigint_copy(&R_hi, R);
+    bigint_shift_right(&R_hi, h);
+    bigint_copy(&R_lo, R);
+    R_lo.length = h;
+    bigint_normalize(&R_lo);
+
+    // Limb i of S = Y · R_hi is limb i + h of the full product, and limb i + h - L of π · B^L
+    bigint_mul(&S, Y, &R_hi);
+    size_t j = Y->length;
+    while (j < S.length && S.limb[j] == CHUDNOVSKY_BASE - 1)
+        j++;
+    size_t end = j + 1 + h > L ? j + 1 + h - L : 0;
+    size_t offset = L - h;
+
+    #pragma omp taskgroup
+    {
+        #pragma omp task default(none) shared(w, S, end, offset, L)
+        chudnovsky_write_limbs(w, &S, offset, end, L);
+        bigint_mul(&S_lo, Y, &R_lo);
+    }
+
+    bigint_shift_left(&S, h);
+    bigint_add(pi, &S, &S_lo);
+    bigint_shift_right(pi, L);
+
+    bigint_free(&R_hi); bigint_free(&R_lo); bigint_free(&S); bigint_free(&S_lo);
+}
+
+/// L, the number of fractional limbs with which the first digits decimals of π are computed
+static size_t chudnovsky_precision(size_t digits){
+    return (digits + CHUDNOVSKY_BASE_DIGITS - 1) / CHUDNOVSKY_BASE_DIGITS + CHUDNOVSKY_GUARD_LIMBS;
+}
+
+/**
+ * Computes π · CHUDNOVSKY_BASE^L, where L = chudnovsky_precision(digits), into pi. Call from inside a
+ * parallel region (e.g. from a single construct) so that the tasks it creates run in parallel. Unless writer is NULL,
+ * the digits that are final before the last multiplication ends are written to it meanwhile; the caller writes the
+ * rest from pi.
+ * @return L
+ */
+size_t chudnovsky_pi_fixed(bigint* pi, size_t digits, chudnovsky_writer* writer){
+    size_t L = chudnovsky_precision(digits);
+    long terms = (long)(digits / CHUDNOVSKY_DIGITS_PER_TERM) + 2;
+
+    int task_depth = 0;
+    for (int t = omp_get_num_threads(); t > 1; t /= 2)
+        task_depth++;
+    task_depth += 4;                // a few more tasks than threads keeps them all busy
+
+    bigint P, Q, T, Y, R;
+    bigint_init(&P); bigint_init(&Q); bigint_init(&T); bigint_init(&Y); bigint_init(&R);
+
+    chudnovsky_split(0, terms, &P, &Q, &T, 0, task_depth);
+
+    // Only the leading L + guard limbs of Q and T carry information at this precision
+    size_t shift_Q = Q.length > L + 2 ? Q.length - (L + 2) : 0;
+    bigint_shift_right(&Q, shift_Q);
+
+    #pragma omp taskgroup
+    {
+        #pragma omp task default(none) shared(Y, L)
+        chudnovsky_inverse_sqrt(&Y, 10005, L);
+        chudnovsky_reciprocal(&R, &T, L);
+    }
+
+    // Q / T · B^L = Q' · R / B^(length of T - shift of Q), where Q' is the truncated Q and B = CHUDNOVSKY_BASE
+    bigint_mul(&R, &Q, &R);
+    if (T.length >= shift_Q)
+        bigint_shift_right(&R, T.length - shift_Q);
+    else
+        bigint_shift_left(&R, shift_Q - T.length);
+
+    // π · B^L = 426880 · (10005 · Y) · (Q / T · B^L) / B^L
+    bigint_mul_small(&Y, 10005);
+    bigint_mul_small(&R, 426880);
+    if (writer != NULL) {
+        chudnovsky_multiply_streaming(pi, &Y, &R, L, writer);
+    } else {
+        bigint_mul(pi, &Y, &R);
+        bigint_shift_right(pi, L);
+    }
+
+    bigint_free(&P); bigint_free(&Q); bigint_free(&T); bigint_free(&Y); bigint_free(&R);
+    return L;
+}
+
+/// Writes "3." followed by the first digits decimals of π, given π · CHUDNOVSKY_BASE^L
+void chudnovsky_write_digits(FILE* out, const bigint* pi, size_t L, size_t digits){
+    chudnovsky_writer* w = (chudnovsky_writer*)malloc(sizeof(chudnovsky_writer));
+    chudnovsky_writer_init(w, out, digits, L);
+    chudnovsky_write_limbs(w, pi, 0, 0, L);
+    chudnovsky_writer_finish(w);
+    free(w);
+}
+
+/**
+ * Computes the first digits decimals of π with number_of_threads threads and, unless out is NULL, writes them to out.
+ * About half of the digits are written while the last multiplication is still running, and the rest once it ends. The
+ * runtime is stored in PI_CHUDNOVSKY_RUNTIME; it includes the output written during the computation, but not the rest.
+ */
+void chudnovsky_pi(size_t digits, int number_of_threads, FILE* out){
+    bigint pi;
+    bigint_init(&pi);
+    size_t L = chudnovsky_precision(digits);
+    chudnovsky_writer* writer = NULL;
+    if (out != NULL) {
+        writer = (chudnovsky_writer*)malloc(sizeof(chudnovsky_writer));
+        chudnovsky_writer_init(writer, out, digits, L);
+    }
+
+    omp_set_num_threads(number_of_threads);
+    double start_time = omp_get_wtime();
+
+    #pragma omp parallel default(none) shared(pi, digits, writer)
+    {
+        #pragma omp single
+        chudnovsky_pi_fixed(&pi, digits, writer);
+    }
+
+    double end_time = omp_get_wtime();
+    PI_CHUDNOVSKY_RUNTIME[0] = end_time - start_time;
+
+    if (writer != NULL) {
+        chudnovsky_write_limbs(writer, &pi, 0, 0, L);
+        chudnovsky_writer_finish(writer);
+        free(writer);
+    }
+    bigint_free(&pi);
+}
+
+// Function to test the performance of the method
+// ----------------------------------------------
+// Known decimals of π for checking the output: the first 50, and decimals 99,951 to 100,000
+#define CHUDNOVSKY_KNOWN_PREFIX "3.14159265358979323846264338327950288419716939937510"
+#define CHUDNOVSKY_KNOWN_SUFFIX "70150789337728658035712790913767420805655493624646"
+#define CHUDNOVSKY_KNOWN_SUFFIX_END 100000
+
+/**
+ * Computes digits decimals of π into a temporary file and compares them with the known prefix and, when at least
+ * CHUDNOVSKY_KNOWN_SUFFIX_END decimals were computed, with the known decimals that end there.
+ * @return 1 if every checked digit matches, 0 otherwise.
+ */
+int chudnovsky_check_digits(size_t digits, int number_of_threads){
+    FILE* f = tmpfile();
+    if (f == NULL)
+        return 0;
+    chudnovsky_pi(digits, number_of_threads, f);
+
+    char text[sizeof(CHUDNOVSKY_KNOWN_PREFIX)];
+    size_t prefix = 2 + (digits < 50 ? digits : 50);
+    rewind(f);
+    int correct = fread(text, 1, prefix, f) == prefix && memcmp(text, CHUDNOVSKY_KNOWN_PREFIX, prefix) == 0;
+
+    size_t suffix = sizeof(CHUDNOVSKY_KNOWN_SUFFIX) - 1;
+    if (correct && digits >= CHUDNOVSKY_KNOWN_SUFFIX_END) {
+        fseek(f, (long)(2 + CHUDNOVSKY_KNOWN_SUFFIX_END - suffix), SEEK_SET);
+        correct = fread(text, 1, suffix, f) == suffix && memcmp(text, CHUDNOVSKY_KNOWN_SUFFIX, suffix) == 0;
+    }
+    fclose(f);
+    return correct;
+}
+
+/**
+ * Reports digits per second for 1, 2, 4, ... up to max_threads threads, then checks the digits computed with
+ * max_threads threads against known decimals of π.
+ */
+void sample_chudnovsky_pi(size_t digits, int max_threads, int number_of_trials){
+    printf("Using the CHUDNOVSKY series (%zu digits):\n", digits);
+    double single_thread_time = 0.0;
+
+    for (int threads = 1; ; threads *= 2) {
+        if (threads > max_threads)
+            threads = max_threads;
+
+        double total_time = 0.0;
+        for (int i = 0; i < number_of_trials; i++) {
+            chudnovsky_pi(digits, threads, NULL);
+            total_time = total_time + PI_CHUDNOVSKY_RUNTIME[0];
+        }
+        total_time = total_time / (double)number_of_trials;
+        if (threads == 1)
+            single_thread_time = total_time;
+
+        printf("%2d threads: %f seconds, %.0f digits per second", threads, total_time, digits / total_time);
+        if (single_thread_time > 0.0)
+            printf(", speedup %.2f", single_thread_time / total_time);
+        printf("\n");
+
+        if (threads == max_threads)
+            break;
+    }
+
+    if (chudnovsky_check_digits(digits, max_threads))
+        printf("The first %zu decimals%s match the known decimals of PI\n", digits < 50 ? digits : 50,
+               digits >= CHUDNOVSKY_KNOWN_SUFFIX_END ? " and decimals 99,951 to 100,000" : "");
+    else
+        printf("WRONG DIGITS\n");
+    printf("\n\n");
+}
+
+#endif //OPENMP_C_TUTORIAL_PI_CHUDNOVSKY_H
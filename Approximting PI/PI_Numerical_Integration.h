@@ -7,8 +7,11 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <omp.h>
+#include "../Autotuning/Autotuner.h"
+#include "../Thread Pool/Thread_Pool.h"
 
 /**
  * The following are parallel implementations of the numerical approximation of the value of π. Each method presents
@@ -33,61 +36,97 @@ double CRITICAL_SECTION_RUNTIME[1];
 double PI_REDUCTION[1];
 double REDUCTION_RUNTIME[1];
 
+double PI_THREAD_POOL[1];
+
+// Tuning parameters of the array-based estimations. They are loaded from the autotuner cache by the first call to
+// either function; the initial values are used when the cache has no entry for them.
+// --------------------------------------------------------------------------------------------------------------
+int PI_NUMBER_OF_THREADS = 10;
+int PI_PADDING = 64;                // distance, in doubles, between the partial sums of two threads in the 2D array
+int PI_TUNING_LOADED = 0;
+
+#define PI_MAX_THREADS 256          // bounds on the cached values, which size the arrays of partial sums
+#define PI_MAX_PADDING 512
+
+void pi_load_tuning(long long int intervals){
+    PI_NUMBER_OF_THREADS = (int)autotune_get_clamped("pi_threads", intervals, PI_NUMBER_OF_THREADS, 1, PI_MAX_THREADS);
+    PI_PADDING = (int)autotune_get_clamped("pi_padding", intervals, PI_PADDING, 1, PI_MAX_PADDING);
+    PI_TUNING_LOADED = 1;
+}
+
 /**
- * Estimating the value of π using 10 threads. Each thread writes to one index of the array sum[]. This code raises the
- * issue of false sharing since threads update contiguous memory locations.
+ * Estimating the value of π using PI_NUMBER_OF_THREADS threads. Each thread writes to one index of the array sum[]. This
+ * code raises the issue of false sharing since threads update contiguous memory locations.
  */
 void numerical_pi_1D_array(long long int intervals){
+    if (!PI_TUNING_LOADED)
+        pi_load_tuning(intervals);
+
+    int threads = PI_NUMBER_OF_THREADS > 0 ? PI_NUMBER_OF_THREADS : 1;
+    double* sum = (double*)calloc(threads, sizeof(double));      // on the heap: the thread count comes from the cache
+
     double start_time = omp_get_wtime();
     double dx = 1.0 / intervals;
     double pi = 0;
-    double sum[10] = {0};
 
-    omp_set_num_threads(10);
+    omp_set_num_threads(threads);
 
-    #pragma omp parallel default(none) shared(intervals) shared(dx) shared(sum)
+    #pragma omp parallel default(none) shared(intervals) shared(dx) shared(sum) shared(threads)
     {
         int id = omp_get_thread_num();
 
-        for (int i = id; i < intervals; i += 10) {
+        for (int i = id; i < intervals; i += threads) {
             double x = (i + 0.5) * dx;
             sum[id] += 4.0 / (1.0 + x * x);
         }
     }
 
-    for (int i = 0; i < 10; i++)
+    for (int i = 0; i < threads; i++)
         pi += sum[i] * dx;
     double end_time = omp_get_wtime();
+    free(sum);
 
     PI_1D_ARR[0] = pi;
     PI_1D_RUNTIME[0] = end_time - start_time;
 }
 
 /**
- * Estimating the value of π using 10 threads. Each thread writes to an index of the 2d array sum. This code resolves
- * issue of false sharing since a sparse matrix is used.
+ * Estimating the value of π using PI_NUMBER_OF_THREADS threads. Each thread writes to a row of the 2d array sum whose
+ * rows are PI_PADDING doubles long. This code resolves issue of false sharing since a sparse matrix is used.
  */
 void numerical_pi_2D_array(long long int intervals) {
+    if (!PI_TUNING_LOADED)
+        pi_load_tuning(intervals);
+
+    int threads = PI_NUMBER_OF_THREADS > 0 ? PI_NUMBER_OF_THREADS : 1;
+    int padding = PI_PADDING > 0 ? PI_PADDING : 1;
+
+    // Up to PI_MAX_THREADS x PI_MAX_PADDING doubles, too much for the stack. Rows start on cache line boundaries, so
+    // a padding of 8 doubles already gives every thread a line of its own.
+    size_t bytes = ((size_t)threads * padding * sizeof(double) + 63) / 64 * 64;
+    double (*sum)[padding] = (double (*)[padding])aligned_alloc(64, bytes);
+    memset(sum, 0, bytes);
+
     double start_time = omp_get_wtime();
     double pi = 0.0;
-    double sum[10][64] = {0};
     double dx = 1.0 / intervals;
-    omp_set_num_threads(10);
+    omp_set_num_threads(threads);
 
-    #pragma omp parallel default(none) shared(intervals) shared(dx) shared(sum)
+    #pragma omp parallel default(none) shared(intervals) shared(dx) shared(sum) shared(threads)
     {
         int id = omp_get_thread_num();
         double x; int i;
-        for(i = id; i < intervals; i += 10){
+        for(i = id; i < intervals; i += threads){
             x = (i + 0.5) * dx;
             sum[id][0] += 4.0/(1.0+x*x);
         }
     }
 
-    for(int i = 0; i < 10; i++)
+    for(int i = 0; i < threads; i++)
         pi += sum[i][0] * dx;
 
     double end_time = omp_get_wtime();
+    free(sum);
 
     PI_2D_ARR[0] = pi;
     PI_2D_RUNTIME[0] = end_time - start_time;
@@ -199,6 +238,54 @@ void numerical_pi_reduction(long long int intervals, int num_threads){
     REDUCTION_RUNTIME[0] = end_time - start_time;
 }
 
+typedef struct {
+    long long int lo;
+    long long int hi;
+    double dx;
+    double sum;
+    thread_pool_future future;
+} pi_range_task;
+
+void pi_range(void* argument){
+    pi_range_task* task = (pi_range_task*)argument;
+    double local_sum = 0;
+    for (long long int i = task->lo; i < task->hi; i++) {
+        double x = (i + 0.5) * task->dx;
+        local_sum += 4.0 / (1.0 + x * x);
+    }
+    task->sum = local_sum;
+}
+
+/**
+ * Estimating the value of π by submitting one task per block of intervals to a persistent thread pool. The workers
+ * are started once, so repeated estimations do not pay for creating a team of threads and changing the global
+ * thread count on every call.
+ */
+void numerical_pi_thread_pool(thread_pool* pool, long long int intervals, int tasks){
+    double start_time = omp_get_wtime();
+    double dx = 1.0 / intervals;
+    double sum = 0;
+    pi_range_task range[tasks];
+
+    for (int t = 0; t < tasks; t++) {
+        range[t].lo = intervals * t / tasks;
+        range[t].hi = intervals * (t + 1) / tasks;
+        range[t].dx = dx;
+        thread_pool_submit(pool, &range[t].future, pi_range, &range[t]);
+    }
+
+    for (int t = 0; t < tasks; t++) {
+        thread_pool_wait(pool, &range[t].future);
+        sum += range[t].sum;
+    }
+
+    double pi = sum * dx;
+    double end_time = omp_get_wtime();
+
+    PI_THREAD_POOL[0] = pi;
+    THREAD_POOL_RUNTIME[0] = end_time - start_time;
+}
+
 // Functions to test the performance of each of the numerical approximations
 // -------------------------------------------------------------------------
 void sample_pi_1D_array(long long int intervals, int number_of_trials){
@@ -295,6 +382,66 @@ void sample_numerical_pi_reduction(long long int intervals, int num_threads, int
     total_time = total_time / (double)number_of_trials;
     printf("The parallel estimation of PI using a REDUCTION clause took on average: %f seconds\n\n\n", total_time);
 }
+void sample_numerical_pi_thread_pool(long long int intervals, int tasks, int num_threads, int number_of_trials){
+    double total_time = 0.0;
+    double pi = 0.0;
+
+    thread_pool pool;
+    thread_pool_init(&pool, num_threads);
+
+    for (int i = 0; i < number_of_trials; i++){
+        numerical_pi_thread_pool(&pool, intervals, tasks);
+        total_time = total_time + THREAD_POOL_RUNTIME[0];
+        pi = pi + PI_THREAD_POOL[0];
+    }
+
+    thread_pool_destroy(&pool);
+
+    printf("Using a THREAD POOL:\n");
+
+    pi = pi / (double)number_of_trials;
+    printf("PI = %0.90lf\n", pi);
+
+    total_time = total_time / (double)number_of_trials;
+    printf("The parallel estimation of PI using a THREAD POOL took on average: %f seconds\n\n\n", total_time);
+}
+
+// Autotuning
+// ----------
+double measure_pi_2D_array_threads(long long threads, long long intervals, void* context){
+    (void)context;
+    PI_NUMBER_OF_THREADS = (int)threads;
+    numerical_pi_2D_array(intervals);
+    return PI_2D_RUNTIME[0];
+}
+
+double measure_pi_2D_array_padding(long long padding, long long intervals, void* context){
+    (void)context;
+    PI_PADDING = (int)padding;
+    numerical_pi_2D_array(intervals);
+    return PI_2D_RUNTIME[0];
+}
+
+/**
+ * Searches the number of threads and the padding of numerical_pi_2D_array() for the given number of intervals, then
+ * saves the results to the autotuner cache. Both array-based estimations use the tuned number of threads.
+ */
+void autotune_numerical_pi(long long int intervals, int number_of_trials){
+    PI_TUNING_LOADED = 1;           // keep the lazy load from overwriting the candidates
+
+    long long threads[AUTOTUNE_MAX_CANDIDATES];
+    int number_of_thread_candidates = autotune_thread_candidates(threads);
+    printf("Tuning the number of threads of the PI estimation (intervals = %lld):\n", intervals);
+    PI_NUMBER_OF_THREADS = (int)autotune_search("pi_threads", intervals, threads, number_of_thread_candidates,
+                                                measure_pi_2D_array_threads, NULL, number_of_trials);
+
+    long long paddings[] = {1, 2, 4, 8, 16, 32, 64};
+    printf("Tuning the padding of the PI estimation (intervals = %lld):\n", intervals);
+    PI_PADDING = (int)autotune_search("pi_padding", intervals, paddings, sizeof(paddings) / sizeof(paddings[0]),
+                                      measure_pi_2D_array_padding, NULL, number_of_trials);
+
+    autotune_save();
+}
 
 
 #endif //OPENMP_C_TUTORIAL_PI_NUMERICAL_INTEGRATION_H
@@ -3,6 +3,10 @@
 //
 
 #include "PI_Numerical_Integration.h"
+#include "PI_Chudnovsky.h"
+
+// Build with: gcc -O2 -fopenmp Test.c -o test -lpthread -lm
+// (-lm because PI_Chudnovsky.h calls sqrt() and pow() from the C math library)
 
 int main() {
 
@@ -21,5 +25,11 @@ int main() {
     sample_numerical_pi_reduction(10000, 10, 100);
     printf("\n\n");
 
+    sample_numerical_pi_thread_pool(10000, 10, 10, 100);
+    printf("\n\n");
+
+    sample_chudnovsky_pi(100000, 4, 3);
+    printf("\n\n");
+
     return 0;
 }
\ No newline at end of file
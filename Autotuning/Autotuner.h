@@ -0,0 +1,193 @@
+#ifndef OPENMP_C_TUTORIAL_AUTOTUNER_H
+#define OPENMP_C_TUTORIAL_AUTOTUNER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <omp.h>
+
+/**
+ * An empirical autotuner for the tuning constants of the kernels in this repository (task cutoffs, thread counts,
+ * padding). Each tuned value is stored under a name and the problem size it was measured for. The results are kept in
+ * a plain text cache file, one "name size value" triple per line, so a new machine only has to be tuned once.
+ *
+ * Kernels call autotune_get() when they start. It loads the cache on first use and returns the value measured for the
+ * nearest problem size, or the kernel's built-in default when nothing has been measured yet.
+ *
+ * The cache file is ".autotune_cache" in the working directory unless the AUTOTUNE_CACHE environment variable names
+ * another path.
+ */
+
+#define AUTOTUNE_MAX_ENTRIES 256
+#define AUTOTUNE_MAX_NAME 48
+#define AUTOTUNE_MAX_CANDIDATES 64
+#define AUTOTUNE_DEFAULT_CACHE ".autotune_cache"
+
+typedef struct {
+    char name[AUTOTUNE_MAX_NAME];
+    long long problem_size;
+    long long value;
+} autotune_entry;
+
+autotune_entry AUTOTUNE_ENTRIES[AUTOTUNE_MAX_ENTRIES];
+int AUTOTUNE_NUMBER_OF_ENTRIES = 0;
+int AUTOTUNE_LOADED = 0;
+
+void autotune_load(void);
+
+const char* autotune_cache_path(void){
+    const char* path = getenv("AUTOTUNE_CACHE");
+    return path != NULL && path[0] != '\0' ? path : AUTOTUNE_DEFAULT_CACHE;
+}
+
+/**
+ * Stores a value, replacing any previous value for the same name and problem size.
+ */
+void autotune_set(const char* name, long long problem_size, long long value){
+    if (!AUTOTUNE_LOADED)
+        autotune_load();        // merge with the cache so that saving does not drop other kernels' values
+
+    for (int i = 0; i < AUTOTUNE_NUMBER_OF_ENTRIES; i++) {
+        if (AUTOTUNE_ENTRIES[i].problem_size == problem_size && strcmp(AUTOTUNE_ENTRIES[i].name, name) == 0) {
+            AUTOTUNE_ENTRIES[i].value = value;
+            return;
+        }
+    }
+    if (AUTOTUNE_NUMBER_OF_ENTRIES == AUTOTUNE_MAX_ENTRIES)
+        return;
+
+    autotune_entry* e = &AUTOTUNE_ENTRIES[AUTOTUNE_NUMBER_OF_ENTRIES++];
+    strncpy(e->name, name, AUTOTUNE_MAX_NAME - 1);
+    e->name[AUTOTUNE_MAX_NAME - 1] = '\0';
+    e->problem_size = problem_size;
+    e->value = value;
+}
+
+/**
+ * Reads the cache file. A missing file is not an error: every kernel then runs with its defaults, and malformed lines
+ * are ignored.
+ */
+void autotune_load(void){
+    AUTOTUNE_LOADED = 1;
+    FILE* f = fopen(autotune_cache_path(), "r");
+    if (f == NULL)
+        return;
+
+    char line[256];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char name[AUTOTUNE_MAX_NAME];
+        long long size, value;
+        char trailing;
+        if (line[0] == '#')
+            continue;
+        // Every tuned parameter is a positive count, so lines that do not parse completely or hold a value below 1
+        // (hand-edited or truncated caches) are skipped instead of reaching a kernel as a zero-length array.
+        if (sscanf(line, "%47s %lld %lld %c", name, &size, &value, &trailing) == 3 && size >= 0 && value >= 1)
+            autotune_set(name, size, value);
+    }
+    fclose(f);
+}
+
+/**
+ * Writes every known value to the cache file.
+ * @return 0 on success, -1 if the file could not be written.
+ */
+int autotune_save(void){
+    FILE* f = fopen(autotune_cache_path(), "w");
+    if (f == NULL)
+        return -1;
+
+    fprintf(f, "# name problem_size value\n");
+    for (int i = 0; i < AUTOTUNE_NUMBER_OF_ENTRIES; i++)
+        fprintf(f, "%s %lld %lld\n", AUTOTUNE_ENTRIES[i].name, AUTOTUNE_ENTRIES[i].problem_size,
+                AUTOTUNE_ENTRIES[i].value);
+    fclose(f);
+    return 0;
+}
+
+/**
+ * Returns the value tuned for the problem size closest to the given one (closest on a logarithmic scale, since the
+ * best cutoffs and thread counts change with the order of magnitude of the input, not its exact size). The ratio of
+ * the two sizes is compared instead of the difference of their logarithms, which orders the entries the same way
+ * without linking libm.
+ * @param default_value Returned when the parameter has never been tuned.
+ */
+long long autotune_get(const char* name, long long problem_size, long long default_value){
+    if (!AUTOTUNE_LOADED)
+        autotune_load();
+
+    long long best = default_value;
+    double best_ratio = INFINITY;
+    for (int i = 0; i < AUTOTUNE_NUMBER_OF_ENTRIES; i++) {
+        if (strcmp(AUTOTUNE_ENTRIES[i].name, name) != 0)
+            continue;
+        double ratio = ((double)AUTOTUNE_ENTRIES[i].problem_size + 1.0) / ((double)problem_size + 1.0);
+        if (ratio < 1.0)
+            ratio = 1.0 / ratio;
+        if (ratio < best_ratio) {
+            best_ratio = ratio;
+            best = AUTOTUNE_ENTRIES[i].value;
+        }
+    }
+    return best;
+}
+
+/**
+ * Same as autotune_get(), but clamps the result to [minimum, maximum]. Kernels that size arrays or thread teams from a
+ * tuned value use this, since the cache is a plain text file that can be edited by hand or copied from another machine.
+ */
+long long autotune_get_clamped(const char* name, long long problem_size, long long default_value, long long minimum,
+                               long long maximum){
+    long long value = autotune_get(name, problem_size, default_value);
+    return value < minimum ? minimum : value > maximum ? maximum : value;
+}
+
+/**
+ * Times every candidate value of one parameter and records the fastest one.
+ * @param measure Runs the kernel once with the candidate value and returns its runtime in seconds.
+ * @param number_of_trials The best of this many runs is kept for each candidate, which filters out noise from other
+ * processes better than the average does.
+ * @return The fastest candidate.
+ */
+long long autotune_search(const char* name, long long problem_size, const long long* candidates, int count,
+                          double (*measure)(long long candidate, long long problem_size, void* context), void* context,
+                          int number_of_trials){
+    long long best = candidates[0];
+    double best_time = INFINITY;
+
+    for (int c = 0; c < count; c++) {
+        double time = INFINITY;
+        for (int t = 0; t < number_of_trials; t++) {
+            double trial = measure(candidates[c], problem_size, context);
+            if (trial < time)
+                time = trial;
+        }
+        printf("  %s = %lld: %f seconds\n", name, candidates[c], time);
+        if (time < best_time) {
+            best_time = time;
+            best = candidates[c];
+        }
+    }
+
+    autotune_set(name, problem_size, best);
+    printf("Best %s for problem size %lld: %lld\n\n", name, problem_size, best);
+    return best;
+}
+
+/**
+ * Fills candidates with the thread counts worth trying on this machine: powers of two up to the number of processors,
+ * and the number of processors itself.
+ * @return The number of candidates written.
+ */
+int autotune_thread_candidates(long long* candidates){
+    int processors = omp_get_num_procs();
+    int count = 0;
+    for (int t = 1; t < processors && count < AUTOTUNE_MAX_CANDIDATES - 1; t *= 2)
+        candidates[count++] = t;
+    candidates[count++] = processors;
+    return count;
+}
+
+#endif //OPENMP_C_TUTORIAL_AUTOTUNER_H
@@ -0,0 +1,457 @@
+#ifndef OPENMP_C_TUTORIAL_GROUP_BY_H
+#define OPENMP_C_TUTORIAL_GROUP_BY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <omp.h>
+#include "../Sorting/Generic_Sort.h"
+
+/**
+ * Reductions keyed by group, where the functions in Integers_Summation.h reduce everything to one scalar.
+ *
+ *  - segmented_sum() sums variable-length segments of an array. Threads split the elements, not the segments, so one
+ *    huge segment does not leave the other threads idle; a segment that crosses a thread boundary is finished with one
+ *    atomic addition per thread, like the partial sums of parallel_sum_using_fixed_number_of_tasks().
+ *  - group_by_sum() computes the sum and the count of the values of every distinct key. Each thread aggregates its
+ *    share of the rows into a thread-local hash table, the way reduction() gives every thread a private copy of the
+ *    sum, and a merge phase combines the tables. The tables are split into GROUP_BY_PARTITIONS partitions by the high
+ *    bits of the hash, so each partition is merged by one thread without any locking.
+ *  - group_by_sum_sort() sorts the rows by key and sums the runs of equal keys with segmented_sum().
+ *
+ * Hashing only pays off when many rows share a key. Every GROUP_BY_CHECK_INTERVAL rows, each thread counts the rows it
+ * has read whose key was already in its tables, and compares them with the repeats that as many rows drawn from
+ * group_by_fallback_keys() keys would hold: that many keys give GROUP_BY_FALLBACK_RATIO * n distinct keys over all n
+ * rows. A thread that sees fewer repeats projects a cardinality too high for the tables to save any work, and
+ * group_by_sum() falls back to group_by_sum_sort(). The test depends on the ratio of groups to rows, not on their
+ * absolute number, so it applies to small inputs as well as large ones and usually decides long before a thread has
+ * read all of its rows. It waits until GROUP_BY_FALLBACK_MIN repeats are expected, so that the few collisions among
+ * the first rows do not decide it by chance.
+ *
+ * Both return the groups in ascending order of key.
+ */
+
+#define GROUP_BY_PARTITIONS 64              // must be a power of two
+#define GROUP_BY_PARTITION_BITS 6
+#define GROUP_BY_FALLBACK_RATIO 0.25    // sort when more than this fraction of the rows are expected to be distinct
+#define GROUP_BY_FALLBACK_MIN 256       // repeated keys expected before a thread may fall back
+#define GROUP_BY_CHECK_INTERVAL 4096        // rows between two checks for the fallback
+
+typedef struct {
+    long long sum;
+    long long count;
+} group_by_aggregate;
+
+typedef struct {
+    uint64_t* keys;
+    group_by_aggregate* values;
+    int64_t groups;
+} group_by_result;
+
+void group_by_result_free(group_by_result* r){
+    free(r->keys);
+    free(r->values);
+    r->keys = NULL;
+    r->values = NULL;
+    r->groups = 0;
+}
+
+// Segmented reduction
+// -------------------
+/**
+ * sums[s] = values[offsets[s]] + ... + values[offsets[s + 1] - 1] for every s < segments. offsets must be
+ * non-decreasing; empty segments sum to 0.
+ */
+void segmented_sum(const long long* values, const int64_t* offsets, int64_t segments, long long* sums,
+                   int number_of_threads){
+    int64_t first = offsets[0];
+    int64_t n = offsets[segments] - first;
+
+    #pragma omp parallel num_threads(number_of_threads) default(none) shared(values, offsets, segments, sums, first, n)
+    {
+        #pragma omp for schedule(static)
+        for (int64_t s = 0; s < segments; s++)
+            sums[s] = 0;
+
+        int t = omp_get_thread_num();
+        int threads = omp_get_num_threads();
+        int64_t lo = first + n * t / threads;
+        int64_t hi = first + n * (t + 1) / threads;
+
+        if (lo < hi) {
+            // The segment that holds element lo: the last s with offsets[s] <= lo
+            int64_t a = 0, b = segments - 1;
+            while (a < b) {
+                int64_t m = a + (b - a + 1) / 2;
+                if (offsets[m] <= lo)
+                    a = m;
+                else
+                    b = m - 1;
+            }
+
+            int64_t s = a;
+            int64_t i = lo;
+            while (i < hi) {
+                int64_t end = offsets[s + 1] < hi ? offsets[s + 1] : hi;
+                long long local_sum = 0;
+                for (; i < end; i++)
+                    local_sum = local_sum + values[i];
+                // Only the first and the last segment of a thread can be shared with another thread
+                if (offsets[s] < lo || offsets[s + 1] > hi) {
+                    #pragma omp atomic
+                    sums[s] += local_sum;
+                } else {
+                    sums[s] += local_sum;
+                }
+                s++;
+            }
+        }
+    }
+}
+
+// Hash tables
+// -----------
+typedef struct {
+    uint64_t key;
+    long long sum;
+    long long count;                    // 0 marks an empty slot
+} group_slot;
+
+// A probe touches a single slot, so a lookup costs one cache miss at most
+typedef struct {
+    group_slot* slots;
+    int64_t capacity;                   // a power of two, at least twice size
+    int64_t size;
+} group_table;
+
+static inline uint64_t group_by_hash(uint64_t key){
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    return key ^ (key >> 33);
+}
+
+static void group_table_init(group_table* t, int64_t capacity){
+    t->slots = (group_slot*)calloc(capacity, sizeof(group_slot));
+    t->capacity = capacity;
+    t->size = 0;
+}
+
+static void group_table_free(group_table* t){
+    free(t->slots);
+}
+
+static void group_table_add(group_table* t, uint64_t key, uint64_t hash, long long sum, long long count);
+
+static void group_table_grow(group_table* t){
+    group_table bigger;
+    group_table_init(&bigger, 2 * t->capacity);
+    for (int64_t i = 0; i < t->capacity; i++) {
+        group_slot* slot = &t->slots[i];
+        if (slot->count != 0)
+            group_table_add(&bigger, slot->key, group_by_hash(slot->key), slot->sum, slot->count);
+    }
+    group_table_free(t);
+    *t = bigger;
+}
+
+/// Adds sum and count (count > 0) to the group of key, inserting the group if needed (linear probing)
+static void group_table_add(group_table* t, uint64_t key, uint64_t hash, long long sum, long long count){
+    int64_t mask = t->capacity - 1;
+    int64_t i = (int64_t)(hash & (uint64_t)mask);
+    while (t->slots[i].count != 0) {
+        if (t->slots[i].key == key) {
+            t->slots[i].sum += sum;
+            t->slots[i].count += count;
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+
+    if (2 * (t->size + 1) > t->capacity) {
+        group_table_grow(t);
+        group_table_add(t, key, hash, sum, count);
+        return;
+    }
+    t->slots[i].key = key;
+    t->slots[i].sum = sum;
+    t->slots[i].count = count;
+    t->size++;
+}
+
+// Group by
+// --------
+/// Sorts the groups of a result by key
+static void group_by_sort_result(group_by_result* r, int number_of_threads){
+    parallel_sort_pairs_uint64(r->keys, r->values, sizeof(group_by_aggregate), r->groups, number_of_threads);
+}
+
+/**
+ * Sort-then-scan group by: sorts a copy of the rows by key, finds where the key changes and sums the runs with
+ * segmented_sum().
+ */
+void group_by_sum_sort(const uint64_t* keys, const long long* values, int64_t n, group_by_result* result,
+                       int number_of_threads){
+    result->groups = 0;
+    result->keys = (uint64_t*)malloc((n > 0 ? n : 1) * sizeof(uint64_t));
+    result->values = (group_by_aggregate*)malloc((n > 0 ? n : 1) * sizeof(group_by_aggregate));
+    if (n == 0)
+        return;
+
+    uint64_t* sorted_keys = (uint64_t*)malloc(n * sizeof(uint64_t));
+    long long* sorted_values = (long long*)malloc(n * sizeof(long long));
+    memcpy(sorted_keys, keys, n * sizeof(uint64_t));
+    memcpy(sorted_values, values, n * sizeof(long long));
+    parallel_sort_pairs_uint64(sorted_keys, sorted_values, sizeof(long long), n, number_of_threads);
+
+    // Offsets of the runs of equal keys: every thread counts the run starts in its part of the rows, and a prefix sum
+    // over the counts tells it where to write them
+    int64_t* offsets = (int64_t*)malloc((n + 1) * sizeof(int64_t));
+    int64_t starts_before[number_of_threads + 1];
+    int64_t groups = 0;
+
+    #pragma omp parallel num_threads(number_of_threads) default(none) \
+            shared(sorted_keys, n, offsets, starts_before, groups)
+    {
+        int t = omp_get_thread_num();
+        int threads = omp_get_num_threads();
+        int64_t lo = n * t / threads;
+        int64_t hi = n * (t + 1) / threads;
+
+        int64_t starts = 0;
+        for (int64_t i = lo; i < hi; i++)
+            starts += i == 0 || sorted_keys[i] != sorted_keys[i - 1];
+        starts_before[t + 1] = starts;
+
+        #pragma omp barrier
+        #pragma omp single
+        {
+            starts_before[0] = 0;
+            for (int i = 1; i <= threads; i++)
+                starts_before[i] += starts_before[i - 1];
+            groups = starts_before[threads];
+            offsets[groups] = n;
+        }
+
+        int64_t g = starts_before[t];
+        for (int64_t i = lo; i < hi; i++)
+            if (i == 0 || sorted_keys[i] != sorted_keys[i - 1])
+                offsets[g++] = i;
+    }
+
+    long long* sums = (long long*)malloc(groups * sizeof(long long));
+    segmented_sum(sorted_values, offsets, groups, sums, number_of_threads);
+
+    #pragma omp parallel for num_threads(number_of_threads) default(none) \
+            shared(result, sorted_keys, offsets, sums, groups) schedule(static)
+    for (int64_t g = 0; g < groups; g++) {
+        result->keys[g] = sorted_keys[offsets[g]];
+        result->values[g].sum = sums[g];
+        result->values[g].count = offsets[g + 1] - offsets[g];
+    }
+    result->groups = groups;
+
+    free(sums);
+    free(offsets);
+    free(sorted_keys);
+    free(sorted_values);
+}
+
+/**
+ * The number of keys K for which n rows drawn uniformly from K keys hold GROUP_BY_FALLBACK_RATIO * n distinct keys on
+ * average, i.e. the solution of K (1 - e^(-n / K)) = GROUP_BY_FALLBACK_RATIO * n. The left side grows with K, so it is
+ * found by bisection between ratio * n and n.
+ */
+static double group_by_fallback_keys(int64_t n){
+    double target = GROUP_BY_FALLBACK_RATIO * (double)n;
+    double lo = target, hi = (double)n;
+    for (int step = 0; step < 50; step++) {
+        double k = 0.5 * (lo + hi);
+        if (k * (1.0 - exp(-(double)n / k)) < target)
+            lo = k;
+        else
+            hi = k;
+    }
+    return hi;
+}
+
+// Set by group_by_sum() when its last call fell back to sorting
+// -------------------------------------------------------------
+int GROUP_BY_FELL_BACK[1];
+
+/**
+ * Hash group by with thread-local partitioned tables and a partition-parallel merge. Falls back to
+ * group_by_sum_sort() when the keys are nearly all distinct.
+ */
+void group_by_sum(const uint64_t* keys, const long long* values, int64_t n, group_by_result* result,
+                  int number_of_threads){
+    group_table* local = (group_table*)malloc((size_t)number_of_threads * GROUP_BY_PARTITIONS * sizeof(group_table));
+    group_table merged[GROUP_BY_PARTITIONS];
+    int64_t partition_offset[GROUP_BY_PARTITIONS + 1];
+    atomic_int fallback = 0;
+    int threads_used = 1;
+    double fallback_keys = group_by_fallback_keys(n);
+
+    #pragma omp parallel num_threads(number_of_threads) default(none) \
+            shared(keys, values, n, result, local, merged, partition_offset, fallback, threads_used, fallback_keys)
+    {
+        int t = omp_get_thread_num();
+        int threads = omp_get_num_threads();
+        #pragma omp single
+        threads_used = threads;
+
+        group_table* mine = local + (size_t)t * GROUP_BY_PARTITIONS;
+        for (int p = 0; p < GROUP_BY_PARTITIONS; p++)
+            group_table_init(&mine[p], 16);
+
+        // Local aggregation
+        int64_t lo = n * t / threads;
+        int64_t hi = n * (t + 1) / threads;
+        int64_t groups = 0;
+        for (int64_t i = lo; i < hi; i++) {
+            uint64_t hash = group_by_hash(keys[i]);
+            group_table* table = &mine[hash >> (64 - GROUP_BY_PARTITION_BITS)];
+            int64_t size = table->size;
+            group_table_add(table, keys[i], hash, values[i], 1);
+            groups += table->size - size;
+
+            if ((i - lo) % GROUP_BY_CHECK_INTERVAL == GROUP_BY_CHECK_INTERVAL - 1) {
+                // Rows whose key was already in the tables, against the number expected if the input had only
+                // fallback_keys keys
+                int64_t rows = i - lo + 1;
+                double expected = (double)rows - fallback_keys * (1.0 - exp(-(double)rows / fallback_keys));
+                if (expected >= GROUP_BY_FALLBACK_MIN && (double)(rows - groups) < expected)
+                    atomic_store_explicit(&fallback, 1, memory_order_relaxed);
+                if (atomic_load_explicit(&fallback, memory_order_relaxed))
+                    break;
+            }
+        }
+        #pragma omp barrier
+
+        if (!atomic_load_explicit(&fallback, memory_order_relaxed)) {
+            // Merge: partition p of every thread's table goes into merged[p]
+            #pragma omp for schedule(dynamic, 1)
+            for (int p = 0; p < GROUP_BY_PARTITIONS; p++) {
+                int64_t size = 0;
+                for (int u = 0; u < threads; u++)
+                    size += local[(size_t)u * GROUP_BY_PARTITIONS + p].size;
+                int64_t capacity = 16;
+                while (capacity < 2 * size)
+                    capacity *= 2;
+                group_table_init(&merged[p], capacity);
+
+                for (int u = 0; u < threads; u++) {
+                    group_table* table = &local[(size_t)u * GROUP_BY_PARTITIONS + p];
+                    for (int64_t s = 0; s < table->capacity; s++) {
+                        group_slot* slot = &table->slots[s];
+                        if (slot->count != 0)
+                            group_table_add(&merged[p], slot->key, group_by_hash(slot->key), slot->sum, slot->count);
+                    }
+                }
+            }
+
+            #pragma omp single
+            {
+                partition_offset[0] = 0;
+                for (int p = 0; p < GROUP_BY_PARTITIONS; p++)
+                    partition_offset[p + 1] = partition_offset[p] + merged[p].size;
+                result->groups = partition_offset[GROUP_BY_PARTITIONS];
+                result->keys = (uint64_t*)malloc((result->groups > 0 ? result->groups : 1) * sizeof(uint64_t));
+                result->values = (group_by_aggregate*)malloc((result->groups > 0 ? result->groups : 1) *
+                                                             sizeof(group_by_aggregate));
+            }
+
+            #pragma omp for schedule(dynamic, 1)
+            for (int p = 0; p < GROUP_BY_PARTITIONS; p++) {
+                int64_t g = partition_offset[p];
+                for (int64_t s = 0; s < merged[p].capacity; s++) {
+                    group_slot* slot = &merged[p].slots[s];
+                    if (slot->count != 0) {
+                        result->keys[g] = slot->key;
+                        result->values[g].sum = slot->sum;
+                        result->values[g].count = slot->count;
+                        g++;
+                    }
+                }
+                group_table_free(&merged[p]);
+            }
+        }
+
+        for (int p = 0; p < GROUP_BY_PARTITIONS; p++)
+            group_table_free(&mine[p]);
+    }
+    free(local);
+
+    GROUP_BY_FELL_BACK[0] = atomic_load(&fallback);
+    if (GROUP_BY_FELL_BACK[0]) {
+        group_by_sum_sort(keys, values, n, result, number_of_threads);
+        return;
+    }
+    group_by_sort_result(result, threads_used);
+}
+
+// Global variables to measure the runtime of the functions
+// --------------------------------------------------------
+double GROUP_BY_HASH_RUNTIME[1];
+double GROUP_BY_SORT_RUNTIME[1];
+
+// Function to test the performance of the method
+// ----------------------------------------------
+/**
+ * Groups n rows whose keys are drawn from `groups` distinct values, with the hash group by and with the
+ * sort-then-scan baseline, and checks that both agree.
+ */
+void sample_group_by(int64_t n, int64_t groups, int number_of_trials, int number_of_threads){
+    uint64_t* keys = (uint64_t*)malloc(n * sizeof(uint64_t));
+    long long* values = (long long*)malloc(n * sizeof(long long));
+    srand(1);
+    for (int64_t i = 0; i < n; i++) {
+        keys[i] = group_by_hash((uint64_t)(((unsigned long long)rand() << 31 | rand()) % groups));
+        values[i] = rand() % 1000;
+    }
+
+    double hash_time = 0.0, sort_time = 0.0;
+    int same = 1;
+    int64_t result_groups = 0;
+    for (int trial = 0; trial < number_of_trials; trial++) {
+        group_by_result hashed, sorted;
+
+        double start_time = omp_get_wtime();
+        group_by_sum(keys, values, n, &hashed, number_of_threads);
+        GROUP_BY_HASH_RUNTIME[0] = omp_get_wtime() - start_time;
+        hash_time += GROUP_BY_HASH_RUNTIME[0];
+
+        start_time = omp_get_wtime();
+        group_by_sum_sort(keys, values, n, &sorted, number_of_threads);
+        GROUP_BY_SORT_RUNTIME[0] = omp_get_wtime() - start_time;
+        sort_time += GROUP_BY_SORT_RUNTIME[0];
+
+        same = same && hashed.groups == sorted.groups;
+        for (int64_t g = 0; same && g < hashed.groups; g++)
+            same = hashed.keys[g] == sorted.keys[g] && hashed.values[g].sum == sorted.values[g].sum &&
+                   hashed.values[g].count == sorted.values[g].count;
+        result_groups = hashed.groups;
+
+        group_by_result_free(&hashed);
+        group_by_result_free(&sorted);
+    }
+    hash_time = hash_time / (double)number_of_trials;
+    sort_time = sort_time / (double)number_of_trials;
+
+    printf("Using GROUP BY on %lld rows (%lld groups):\n", (long long)n, (long long)result_groups);
+    printf("The HASH group by%s took on average: %f seconds (%.1f million rows per second)\n",
+           GROUP_BY_FELL_BACK[0] ? " (fell back to sorting)" : "", hash_time, n / hash_time / 1e6);
+    printf("The SORT-THEN-SCAN group by took on average: %f seconds (%.1f million rows per second)\n", sort_time,
+           n / sort_time / 1e6);
+    printf("The results %s\n\n\n", same ? "agree" : "DIFFER");
+
+    free(keys);
+    free(values);
+}
+
+#endif //OPENMP_C_TUTORIAL_GROUP_BY_H
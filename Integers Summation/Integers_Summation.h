@@ -9,6 +9,8 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <omp.h>
+#include "../Thread Pool/Thread_Pool.h"
+#include "../Tracing/Task_Trace.h"
 
 // Variables used for testing:
 // --------------------------
@@ -30,6 +32,8 @@ double SCHEDULING_TASKS_RUNTIME[1];
 unsigned long long int SUM_FIXED_TASKS[1];
 double FIXED_TASKS_RUNTIME[1];
 
+unsigned long long int SUM_THREAD_POOL[1];
+
 /**
  * Sequential summation of integers from a given interval.
  * @param N
@@ -158,10 +162,12 @@ void parallel_sum_using_fixed_number_of_tasks(long long int N, int tasks, int nu
     unsigned long long int sum = 0;
     #pragma omp parallel default(none) shared(tasks) shared(N) shared(sum)
     {
-        #pragma omp single
+        TRACE_REGION_BEGIN("fixed tasks summation");
+        #pragma omp single nowait
         for (int t = 0; t < tasks; t++){
-            #pragma omp task default(none) shared(tasks) shared(t) shared(sum) shared(N)
+            #pragma omp task default(none) shared(tasks) firstprivate(t) shared(sum) shared(N)
             {
+                TRACE_TASK_BEGIN("sum range");
                 unsigned long long local_sum = 0;
                 unsigned long long lo = (N / tasks) * (t + 0) + 1;
                 unsigned long long hi = (N / tasks) * (t + 1) + 0;
@@ -169,8 +175,15 @@ void parallel_sum_using_fixed_number_of_tasks(long long int N, int tasks, int nu
                     local_sum = local_sum + i;
                 #pragma omp atomic
                     sum = sum + local_sum;
+                TRACE_TASK_END("sum range");
             }
         }
+        // The barrier that ends the single construct, made explicit so that the trace shows it. Threads run the
+        // queued tasks while they wait here, so the task slices appear nested inside the barrier.
+        TRACE_BARRIER_BEGIN();
+        #pragma omp barrier
+        TRACE_BARRIER_END();
+        TRACE_REGION_END("fixed tasks summation");
     }
 
     double end_time = omp_get_wtime();
@@ -178,6 +191,50 @@ void parallel_sum_using_fixed_number_of_tasks(long long int N, int tasks, int nu
     FIXED_TASKS_RUNTIME[0] = end_time - start_time;
 }
 
+typedef struct {
+    unsigned long long lo;
+    unsigned long long hi;
+    unsigned long long sum;
+    thread_pool_future future;
+} sum_range_task;
+
+void sum_range(void* argument){
+    sum_range_task* task = (sum_range_task*)argument;
+    unsigned long long local_sum = 0;
+    for (unsigned long long int i = task->lo; i <= task->hi; i++)
+        local_sum = local_sum + i;
+    task->sum = local_sum;
+}
+
+/**
+ * Implementing summation of integers by submitting a fixed number of tasks to a persistent thread pool. Unlike the
+ * OpenMP versions, no team of threads is created per call, which pays off when the function is called very often with
+ * small values of N.
+ */
+void parallel_sum_thread_pool(thread_pool* pool, unsigned long long int N, int tasks){
+    if (N % tasks != 0)
+        return;
+
+    double start_time = omp_get_wtime();
+    sum_range_task range[tasks];
+
+    for (int t = 0; t < tasks; t++){
+        range[t].lo = (N / tasks) * (t + 0) + 1;
+        range[t].hi = (N / tasks) * (t + 1) + 0;
+        thread_pool_submit(pool, &range[t].future, sum_range, &range[t]);
+    }
+
+    unsigned long long sum = 0;
+    for (int t = 0; t < tasks; t++){
+        thread_pool_wait(pool, &range[t].future);
+        sum = sum + range[t].sum;
+    }
+
+    double end_time = omp_get_wtime();
+    SUM_THREAD_POOL[0] = sum;
+    THREAD_POOL_RUNTIME[0] = end_time - start_time;
+}
+
 // Functions to test the performance of each function
 // ---------------------------------------------------
 void sample_sequential_summation(long long int N, int number_of_trials){
@@ -300,4 +357,29 @@ void sample_fixed_tasks_summation(long long int N, int tasks, int number_of_tria
     printf("The FIXED TASKS summation took on average: %f seconds\n\n\n", total_time);
 }
 
+void sample_thread_pool_summation(unsigned long long int N, int tasks, int number_of_trials, int number_of_threads){
+    double total_time = 0.0;
+    unsigned long long sum = 0;
+
+    thread_pool pool;
+    thread_pool_init(&pool, number_of_threads);
+
+    for (int i = 0; i < number_of_trials; i++){
+        parallel_sum_thread_pool(&pool, N, tasks);
+        total_time = total_time + THREAD_POOL_RUNTIME[0];
+        sum = sum + SUM_THREAD_POOL[0];
+    }
+
+    thread_pool_destroy(&pool);
+
+    printf("Using the THREAD POOL algorithm:\n");
+    sum = sum / (unsigned long long)number_of_trials;
+
+    printf("SUM = %llu\n", sum);
+
+    total_time = total_time / (double)number_of_trials;
+
+    printf("The THREAD POOL summation took on average: %f seconds\n\n\n", total_time);
+}
+
 #endif //OPENMP_C_TUTORIAL_INTEGERS_SUMMATION_H
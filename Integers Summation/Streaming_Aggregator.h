@@ -0,0 +1,332 @@
+#ifndef OPENMP_C_TUTORIAL_STREAMING_AGGREGATOR_H
+#define OPENMP_C_TUTORIAL_STREAMING_AGGREGATOR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <omp.h>
+#include "../Sorting/Generic_Sort.h"
+
+/**
+ * Running totals (sum, count, minimum and maximum) of values that many producer threads push continuously, unlike the
+ * functions in Integers_Summation.h, which reduce a range that is known in advance.
+ *
+ *  - Every producer owns a stream_producer with a private buffer. stream_push() appends to it without any lock or
+ *    atomic operation.
+ *  - When the buffer is full, the producer reduces the whole batch locally and folds the result into one shard of the
+ *    aggregator with a single short write. Producers are spread over STREAM_SHARDS shards, each on its own cache line,
+ *    so producers with different shards never touch the same line.
+ *  - Each shard is protected by a sequence lock. A writer makes the sequence odd, updates the shard and makes it even
+ *    again; stream_aggregator_snapshot() reads a shard without writing anything and retries only if the sequence changed
+ *    under it. Reads therefore never slow the producers down.
+ *
+ * A batch is folded into a single shard in one step, so a snapshot always covers whole batches: its count, sum,
+ * minimum and maximum describe the same set of values. Values still in a producer's buffer are not visible until the
+ * buffer fills or stream_producer_flush() is called.
+ */
+
+#define STREAM_SHARDS 64
+#define STREAM_BATCH 256                // values buffered by a producer before they are folded
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STREAM_PAUSE() _mm_pause()
+#else
+#define STREAM_PAUSE() ((void)0)
+#endif
+
+typedef struct {
+    long long sum;
+    long long count;
+    long long min;                      // LLONG_MAX while count is 0
+    long long max;                      // LLONG_MIN while count is 0
+} stream_aggregate;
+
+// The fields are atomics only so that the lock-free reads of a snapshot are not data races; the sequence lock, not
+// the atomicity of each field, is what makes a snapshot consistent.
+typedef struct {
+    _Alignas(64) atomic_uint sequence;  // odd while a writer updates the shard
+    atomic_llong sum;
+    atomic_llong count;
+    atomic_llong min;
+    atomic_llong max;
+} stream_shard;
+
+typedef struct {
+    stream_shard shards[STREAM_SHARDS];
+} stream_aggregator;
+
+typedef struct {
+    stream_aggregator* aggregator;
+    stream_shard* shard;
+    int used;
+    long long buffer[STREAM_BATCH];
+} stream_producer;
+
+void stream_aggregate_init(stream_aggregate* a){
+    a->sum = 0;
+    a->count = 0;
+    a->min = LLONG_MAX;
+    a->max = LLONG_MIN;
+}
+
+void stream_aggregator_init(stream_aggregator* a){
+    for (int s = 0; s < STREAM_SHARDS; s++) {
+        atomic_init(&a->shards[s].sequence, 0);
+        atomic_init(&a->shards[s].sum, 0);
+        atomic_init(&a->shards[s].count, 0);
+        atomic_init(&a->shards[s].min, LLONG_MAX);
+        atomic_init(&a->shards[s].max, LLONG_MIN);
+    }
+}
+
+/// Attaches a producer to the aggregator. Producers with different ids below STREAM_SHARDS never share a shard.
+void stream_producer_init(stream_producer* p, stream_aggregator* a, int id){
+    p->aggregator = a;
+    p->shard = &a->shards[id % STREAM_SHARDS];
+    p->used = 0;
+}
+
+/// Reduces the producer's buffer and folds it into its shard
+void stream_producer_flush(stream_producer* p){
+    if (p->used == 0)
+        return;
+
+    stream_aggregate batch;
+    stream_aggregate_init(&batch);
+    for (int i = 0; i < p->used; i++) {
+        long long x = p->buffer[i];
+        batch.sum += x;
+        batch.min = x < batch.min ? x : batch.min;
+        batch.max = x > batch.max ? x : batch.max;
+    }
+    batch.count = p->used;
+    p->used = 0;
+
+    // Producers that share a shard take turns by moving the sequence from even to odd
+    stream_shard* s = p->shard;
+    unsigned int sequence = atomic_load_explicit(&s->sequence, memory_order_relaxed);
+    while ((sequence & 1) || !atomic_compare_exchange_weak_explicit(&s->sequence, &sequence, sequence + 1,
+                                                                    memory_order_acquire, memory_order_relaxed)) {
+        STREAM_PAUSE();
+        sequence = atomic_load_explicit(&s->sequence, memory_order_relaxed);
+    }
+    atomic_thread_fence(memory_order_release);      // the odd sequence is visible before any field changes
+
+    long long min = atomic_load_explicit(&s->min, memory_order_relaxed);
+    long long max = atomic_load_explicit(&s->max, memory_order_relaxed);
+    atomic_store_explicit(&s->sum, atomic_load_explicit(&s->sum, memory_order_relaxed) + batch.sum,
+                          memory_order_relaxed);
+    atomic_store_explicit(&s->count, atomic_load_explicit(&s->count, memory_order_relaxed) + batch.count,
+                          memory_order_relaxed);
+    atomic_store_explicit(&s->min, batch.min < min ? batch.min : min, memory_order_relaxed);
+    atomic_store_explicit(&s->max, batch.max > max ? batch.max : max, memory_order_relaxed);
+
+    atomic_store_explicit(&s->sequence, sequence + 2, memory_order_release);
+}
+
+static inline void stream_push(stream_producer* p, long long value){
+    p->buffer[p->used++] = value;
+    if (p->used == STREAM_BATCH)
+        stream_producer_flush(p);
+}
+
+/**
+ * Combines the shards into out. Each shard is read under its sequence lock, so out describes a set of complete
+ * batches. A snapshot never blocks a producer.
+ */
+void stream_aggregator_snapshot(stream_aggregator* a, stream_aggregate* out){
+    stream_aggregate_init(out);
+    for (int i = 0; i < STREAM_SHARDS; i++) {
+        stream_shard* s = &a->shards[i];
+        long long sum, count, min, max;
+        unsigned int before, after;
+        do {
+            before = atomic_load_explicit(&s->sequence, memory_order_acquire);
+            if (before & 1) {
+                STREAM_PAUSE();
+                continue;
+            }
+            sum = atomic_load_explicit(&s->sum, memory_order_relaxed);
+            count = atomic_load_explicit(&s->count, memory_order_relaxed);
+            min = atomic_load_explicit(&s->min, memory_order_relaxed);
+            max = atomic_load_explicit(&s->max, memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);  // the fields are read before the sequence is checked again
+            after = atomic_load_explicit(&s->sequence, memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        out->sum += sum;
+        out->count += count;
+        out->min = min < out->min ? min : out->min;
+        out->max = max > out->max ? max : out->max;
+    }
+}
+
+// Global variables to measure the runtime of the functions
+// --------------------------------------------------------
+stream_aggregate STREAM_RESULT[1];
+double STREAM_RUNTIME[1];
+double STREAM_LATENCY[3];               // 50th, 99th and 99.9th percentile of a push, in nanoseconds
+
+#define STREAM_LATENCY_STRIDE 61        // time one push in this many; prime, so batch boundaries are sampled fairly
+
+typedef enum {
+    STREAM_METHOD_AGGREGATOR,
+    STREAM_METHOD_CRITICAL,
+    STREAM_METHOD_ATOMIC
+} stream_method;
+
+static inline unsigned long long stream_now(void){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (unsigned long long)t.tv_sec * 1000000000ULL + (unsigned long long)t.tv_nsec;
+}
+
+/**
+ * Every thread pushes its share of the values 1..N (in a scrambled order, so the minimum and maximum keep changing)
+ * with the given method, and every STREAM_LATENCY_STRIDE-th push is timed. The totals go to STREAM_RESULT, the wall
+ * time to STREAM_RUNTIME and the latency percentiles to STREAM_LATENCY. A timed push includes the cost of reading the
+ * clock, which is the same for every method.
+ */
+void streaming_ingestion(unsigned long long N, stream_method method, int number_of_threads){
+    stream_aggregator* aggregator = (stream_aggregator*)aligned_alloc(64, sizeof(stream_aggregator));
+    stream_aggregator_init(aggregator);
+
+    stream_aggregate shared_total;      // used by the critical section
+    stream_aggregate_init(&shared_total);
+    long long atomic_sum = 0, atomic_count = 0;
+    atomic_llong atomic_min = LLONG_MAX, atomic_max = LLONG_MIN;
+
+    unsigned long long samples_per_thread = N / ((unsigned long long)number_of_threads * STREAM_LATENCY_STRIDE) + 1;
+    uint64_t* latency = (uint64_t*)malloc(samples_per_thread * number_of_threads * sizeof(uint64_t));
+    long long samples_taken[number_of_threads];
+    memset(samples_taken, 0, sizeof(samples_taken));       // the runtime may start fewer threads than requested
+
+    double start_time = omp_get_wtime();
+    #pragma omp parallel num_threads(number_of_threads) default(none) \
+            shared(N, method, aggregator, shared_total, atomic_sum, atomic_count, atomic_min, atomic_max, \
+                   latency, samples_per_thread, samples_taken)
+    {
+        int t = omp_get_thread_num();
+        int threads = omp_get_num_threads();
+        stream_producer producer;
+        stream_producer_init(&producer, aggregator, t);
+        uint64_t* my_latency = latency + t * samples_per_thread;
+        long long samples = 0;
+
+        unsigned long long lo = N * t / threads + 1;
+        unsigned long long hi = N * (t + 1) / threads;
+        for (unsigned long long i = lo; i <= hi; i++) {
+            long long x = (long long)((i * 2654435761ULL) % N) + 1;        // 2654435761 is prime: a permutation of 1..N
+            int timed = (i - lo) % STREAM_LATENCY_STRIDE == 0;
+            unsigned long long push_start = timed ? stream_now() : 0;
+
+            switch (method) {
+                case STREAM_METHOD_AGGREGATOR:
+                    stream_push(&producer, x);
+                    break;
+                case STREAM_METHOD_CRITICAL:
+                    #pragma omp critical
+                    {
+                        shared_total.sum += x;
+                        shared_total.count++;
+                        shared_total.min = x < shared_total.min ? x : shared_total.min;
+                        shared_total.max = x > shared_total.max ? x : shared_total.max;
+                    }
+                    break;
+                case STREAM_METHOD_ATOMIC: {
+                    #pragma omp atomic
+                    atomic_sum += x;
+                    #pragma omp atomic
+                    atomic_count++;
+                    long long m = atomic_load_explicit(&atomic_min, memory_order_relaxed);
+                    while (x < m && !atomic_compare_exchange_weak(&atomic_min, &m, x))
+                        ;
+                    m = atomic_load_explicit(&atomic_max, memory_order_relaxed);
+                    while (x > m && !atomic_compare_exchange_weak(&atomic_max, &m, x))
+                        ;
+                    break;
+                }
+            }
+
+            if (timed && samples < (long long)samples_per_thread)
+                my_latency[samples++] = stream_now() - push_start;
+        }
+        stream_producer_flush(&producer);
+        samples_taken[t] = samples;
+    }
+    STREAM_RUNTIME[0] = omp_get_wtime() - start_time;
+
+    if (method == STREAM_METHOD_AGGREGATOR) {
+        stream_aggregator_snapshot(aggregator, &STREAM_RESULT[0]);
+    } else if (method == STREAM_METHOD_CRITICAL) {
+        STREAM_RESULT[0] = shared_total;
+    } else {
+        STREAM_RESULT[0].sum = atomic_sum;
+        STREAM_RESULT[0].count = atomic_count;
+        STREAM_RESULT[0].min = atomic_load(&atomic_min);
+        STREAM_RESULT[0].max = atomic_load(&atomic_max);
+    }
+
+    // Percentiles over the samples of all threads
+    long long total_samples = 0;
+    for (int t = 0; t < number_of_threads; t++) {
+        for (long long s = 0; s < samples_taken[t]; s++)
+            latency[total_samples + s] = latency[t * samples_per_thread + s];
+        total_samples += samples_taken[t];
+    }
+    parallel_sort_uint64(latency, total_samples, number_of_threads);
+    double percentiles[3] = {0.50, 0.99, 0.999};
+    for (int p = 0; p < 3; p++)
+        STREAM_LATENCY[p] = total_samples > 0 ? (double)latency[(long long)(percentiles[p] * (total_samples - 1))] : 0.0;
+
+    free(latency);
+    free(aggregator);
+}
+
+// Function to test the performance of the method
+// ----------------------------------------------
+/**
+ * Compares the ingestion throughput and push latency of the streaming aggregator with a critical section and with
+ * atomic updates, then measures how long a snapshot takes.
+ */
+void sample_streaming_aggregation(unsigned long long N, int number_of_trials, int number_of_threads){
+    const char* names[3] = {"STREAMING AGGREGATOR", "CRITICAL SECTION", "ATOMIC ACCESS"};
+
+    for (int method = 0; method < 3; method++) {
+        double total_time = 0.0, latency[3] = {0.0, 0.0, 0.0};
+        for (int i = 0; i < number_of_trials; i++) {
+            streaming_ingestion(N, (stream_method)method, number_of_threads);
+            total_time = total_time + STREAM_RUNTIME[0];
+            for (int p = 0; p < 3; p++)
+                latency[p] = latency[p] + STREAM_LATENCY[p];
+        }
+        total_time = total_time / (double)number_of_trials;
+
+        printf("Using the %s for streaming ingestion:\n", names[method]);
+        printf("SUM = %lld, COUNT = %lld, MIN = %lld, MAX = %lld\n", STREAM_RESULT[0].sum, STREAM_RESULT[0].count,
+               STREAM_RESULT[0].min, STREAM_RESULT[0].max);
+        printf("The ingestion took on average: %f seconds (%.1f million values per second)\n", total_time,
+               N / total_time / 1e6);
+        printf("Push latency: p50 %.0f ns, p99 %.0f ns, p99.9 %.0f ns\n\n\n", latency[0] / number_of_trials,
+               latency[1] / number_of_trials, latency[2] / number_of_trials);
+    }
+
+    stream_aggregator* aggregator = (stream_aggregator*)aligned_alloc(64, sizeof(stream_aggregator));
+    stream_aggregator_init(aggregator);
+    stream_aggregate snapshot;
+    int reads = 100000;
+    double start_time = omp_get_wtime();
+    for (int i = 0; i < reads; i++)
+        stream_aggregator_snapshot(aggregator, &snapshot);
+    printf("A snapshot of the STREAMING AGGREGATOR took on average: %.0f ns\n\n\n",
+           (omp_get_wtime() - start_time) / reads * 1e9);
+    free(aggregator);
+}
+
+#endif //OPENMP_C_TUTORIAL_STREAMING_AGGREGATOR_H
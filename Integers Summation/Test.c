@@ -0,0 +1,30 @@
+#include "Integers_Summation.h"
+#include "Streaming_Aggregator.h"
+#include "Group_By.h"
+
+int main() {
+
+    sample_sequential_summation(10000000, 10);
+
+    sample_critical_section_summation(10000000, 10, 4);
+
+    sample_atomic_access_summation(10000000, 10, 4);
+
+    sample_reduction_summation(10000000, 10, 4);
+
+    sample_scheduled_tasks_summation(10000000, 10, 4);
+
+    sample_fixed_tasks_summation(10000000, 100, 10, 4);
+
+    sample_thread_pool_summation(10000000, 100, 10, 4);
+
+    sample_streaming_aggregation(10000000, 3, 4);
+
+    // Few groups: the hash tables aggregate most rows in place
+    sample_group_by(4000000, 1000, 3, 4);
+
+    // About 630,000 groups in 1,000,000 rows: group_by_sum() falls back to sorting
+    sample_group_by(1000000, 1000000, 3, 4);
+
+    return 0;
+}
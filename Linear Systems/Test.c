@@ -0,0 +1,12 @@
+#include "Tiled_Factorization.h"
+
+int main() {
+
+    sample_lu_factorization(512, 64, 5, 10);
+    printf("\n\n");
+
+    sample_cholesky_factorization(512, 64, 5, 10);
+    printf("\n\n");
+
+    return 0;
+}
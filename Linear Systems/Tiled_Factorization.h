@@ -0,0 +1,438 @@
+#ifndef OPENMP_C_TUTORIAL_TILED_FACTORIZATION_H
+#define OPENMP_C_TUTORIAL_TILED_FACTORIZATION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <omp.h>
+#include "../Memory Arena/Arena_Allocator.h"
+#include "../Matrix Multiplication/Tile_Kernels.h"
+
+/**
+ * Tiled LU factorization with partial pivoting and tiled Cholesky factorization, expressed as OpenMP tasks with depend
+ * clauses. The matrix is stored as an nt x nt grid of contiguous nb x nb tiles (T[i * nt + j] is tile (i, j)), and every
+ * step of the factorization is a task that names the tiles it reads and writes. The runtime then executes the steps as
+ * a dataflow graph: the trailing updates of step k overlap with the panel of step k + 1 as soon as the tiles it needs are
+ * ready, instead of waiting at the barrier that ends each step of a fork-join blocked factorization.
+ *
+ * The trailing updates are the tile kernels of Matrix Multiplication/Tile_Kernels.h. Both factorizations require n to be
+ * a multiple of the tile size nb.
+ */
+
+// Global variables to measure the runtime of the functions
+// --------------------------------------------------------
+double SEQUENTIAL_LU_RUNTIME[1];
+double TILED_LU_RUNTIME[1];
+double SEQUENTIAL_CHOLESKY_RUNTIME[1];
+double TILED_CHOLESKY_RUNTIME[1];
+
+// Tile layout
+// -----------
+/**
+ * Copies the n x n matrix A into tiles drawn from the arena.
+ */
+double** tile_matrix(arena* a, double** A, int n, int nb){
+    int nt = n / nb;
+    double** T = (double**)arena_alloc(a, (size_t)nt * nt * sizeof(double*));
+    for (int t = 0; t < nt * nt; t++)
+        T[t] = (double*)arena_alloc(a, (size_t)nb * nb * sizeof(double));
+
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            T[(i / nb) * nt + j / nb][(i % nb) * nb + j % nb] = A[i][j];
+    return T;
+}
+
+/**
+ * Copies the tiles back into the n x n matrix A.
+ */
+void untile_matrix(double** T, double** A, int n, int nb){
+    int nt = n / nb;
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            A[i][j] = T[(i / nb) * nt + j / nb][(i % nb) * nb + j % nb];
+}
+
+// Sequential references
+// ---------------------
+/**
+ * Right-looking LU factorization with partial pivoting (LAPACK's getf2). On return A holds L (unit diagonal, below) and
+ * U (on and above the diagonal), and row i was swapped with row ipiv[i] at step i.
+ * @return 0, or 1 + the column of the first exactly zero pivot.
+ */
+int sequential_lu_factorization(double** A, int* ipiv, int n){
+    double start_time = omp_get_wtime();
+    int info = 0;
+
+    for (int k = 0; k < n; k++) {
+        int p = k;
+        for (int i = k + 1; i < n; i++)
+            if (fabs(A[i][k]) > fabs(A[p][k]))
+                p = i;
+        ipiv[k] = p;
+        if (p != k) {
+            double* temp = A[k];
+            A[k] = A[p];
+            A[p] = temp;
+        }
+        if (A[k][k] == 0.0) {
+            if (info == 0)
+                info = k + 1;
+            continue;
+        }
+        for (int i = k + 1; i < n; i++) {
+            double l = A[i][k] / A[k][k];
+            A[i][k] = l;
+            for (int j = k + 1; j < n; j++)
+                A[i][j] -= l * A[k][j];
+        }
+    }
+
+    double end_time = omp_get_wtime();
+    SEQUENTIAL_LU_RUNTIME[0] = end_time - start_time;
+    return info;
+}
+
+/**
+ * Cholesky factorization A = L • transpose_of_L of a symmetric positive definite matrix. Only the lower triangle is
+ * read; on return it holds L.
+ * @return 0, or 1 + the column where A turned out not to be positive definite.
+ */
+int sequential_cholesky_factorization(double** A, int n){
+    double start_time = omp_get_wtime();
+    int info = 0;
+
+    for (int k = 0; k < n && info == 0; k++) {
+        if (A[k][k] <= 0.0) {
+            info = k + 1;
+            break;
+        }
+        double d = sqrt(A[k][k]);
+        A[k][k] = d;
+        for (int i = k + 1; i < n; i++)
+            A[i][k] /= d;
+        for (int j = k + 1; j < n; j++)
+            for (int i = j; i < n; i++)
+                A[i][j] -= A[i][k] * A[j][k];
+    }
+
+    double end_time = omp_get_wtime();
+    SEQUENTIAL_CHOLESKY_RUNTIME[0] = end_time - start_time;
+    return info;
+}
+
+// LU tasks
+// --------
+/**
+ * Factors the panel formed by tile column k, from tile row k down: partial pivoting over all rows of the panel, then
+ * the scaling and rank-1 update of the panel columns. Swaps are applied to the panel only; the other tile columns
+ * apply them in their own tasks.
+ */
+void lu_panel(double** T, int* ipiv, int nt, int nb, int k, int* info){
+    double* diagonal = T[k * nt + k];
+
+    for (int c = 0; c < nb; c++) {
+        // Search the pivot tile by tile, from row c of the diagonal tile down
+        int p_tile = k, p_row = c;
+        double max = fabs(diagonal[c * nb + c]);
+        for (int i = k; i < nt; i++) {
+            const double* tile = T[i * nt + k];
+            for (int r = i == k ? c + 1 : 0; r < nb; r++) {
+                double v = fabs(tile[r * nb + c]);
+                if (v > max) {
+                    max = v;
+                    p_tile = i;
+                    p_row = r;
+                }
+            }
+        }
+        ipiv[k * nb + c] = p_tile * nb + p_row;
+
+        double* pivot_row = diagonal + c * nb;
+        if (p_tile != k || p_row != c) {
+            double* other = T[p_tile * nt + k] + p_row * nb;
+            for (int j = 0; j < nb; j++) {
+                double temp = pivot_row[j];
+                pivot_row[j] = other[j];
+                other[j] = temp;
+            }
+        }
+
+        double pivot = pivot_row[c];
+        if (pivot == 0.0) {
+            if (*info == 0)
+                *info = k * nb + c + 1;
+            continue;
+        }
+        for (int i = k; i < nt; i++) {
+            double* tile = T[i * nt + k];
+            for (int r = i == k ? c + 1 : 0; r < nb; r++) {
+                double* row = tile + r * nb;
+                double l = row[c] / pivot;
+                row[c] = l;
+                for (int j = c + 1; j < nb; j++)
+                    row[j] -= l * pivot_row[j];
+            }
+        }
+    }
+}
+
+/// Applies the row interchanges of panel k to tile column j
+void lu_swap_rows(double** T, const int* ipiv, int nt, int nb, int k, int j){
+    for (int kk = k * nb; kk < (k + 1) * nb; kk++) {
+        int p = ipiv[kk];
+        if (p == kk)
+            continue;
+        double* row_kk = T[(kk / nb) * nt + j] + (kk % nb) * nb;
+        double* row_p = T[(p / nb) * nt + j] + (p % nb) * nb;
+        for (int c = 0; c < nb; c++) {
+            double temp = row_kk[c];
+            row_kk[c] = row_p[c];
+            row_p[c] = temp;
+        }
+    }
+}
+
+/// B = inverse_of_L • B, where L is the unit lower triangle of the tile L
+void tile_lower_unit_solve(const double* L, double* B, int nb){
+    for (int r = 1; r < nb; r++)
+        for (int q = 0; q < r; q++) {
+            double l = L[r * nb + q];
+            for (int c = 0; c < nb; c++)
+                B[r * nb + c] -= l * B[q * nb + c];
+        }
+}
+
+/**
+ * Tiled LU factorization with partial pivoting of the matrix held in tiles T (see tile_matrix()). The result, including
+ * ipiv, is the same as that of sequential_lu_factorization() up to round-off.
+ * @return 0, 1 + the column of the first exactly zero pivot, or -1 if n is not a multiple of nb.
+ */
+int tiled_lu_factorization(double** T, int* ipiv, int n, int nb, int number_of_threads){
+    if (n % nb != 0)
+        return -1;
+
+    int nt = n / nb;
+    int info = 0;
+    omp_set_num_threads(number_of_threads);
+    double start_time = omp_get_wtime();
+
+    #pragma omp parallel default(none) shared(T, ipiv, nt, nb, info)
+    #pragma omp single
+    for (int k = 0; k < nt; k++) {
+        // The panel reads and writes every tile of column k from row k down
+        #pragma omp task default(none) shared(T, ipiv, nt, nb, info) firstprivate(k) \
+                depend(iterator(i = k:nt), inout: T[i * nt + k])
+        lu_panel(T, ipiv, nt, nb, k, &info);
+
+        // Columns left of the panel only need the row interchanges
+        for (int j = 0; j < k; j++) {
+            #pragma omp task default(none) shared(T, ipiv, nt, nb) firstprivate(k, j) \
+                    depend(iterator(i = k:nt), in: T[i * nt + k]) depend(iterator(i = k:nt), inout: T[i * nt + j])
+            lu_swap_rows(T, ipiv, nt, nb, k, j);
+        }
+
+        for (int j = k + 1; j < nt; j++) {
+            // Row interchanges, then the triangular solve that turns tile (k, j) into a tile of U
+            #pragma omp task default(none) shared(T, ipiv, nt, nb) firstprivate(k, j) \
+                    depend(iterator(i = k:nt), in: T[i * nt + k]) depend(iterator(i = k:nt), inout: T[i * nt + j])
+            {
+                lu_swap_rows(T, ipiv, nt, nb, k, j);
+                tile_lower_unit_solve(T[k * nt + k], T[k * nt + j], nb);
+            }
+
+            // Trailing update of the tiles below it
+            for (int i = k + 1; i < nt; i++) {
+                #pragma omp task default(none) shared(T, nt, nb) firstprivate(k, j, i) \
+                        depend(in: T[i * nt + k], T[k * nt + j]) depend(inout: T[i * nt + j])
+                tile_multiply_subtract(T[i * nt + k], T[k * nt + j], T[i * nt + j], nb);
+            }
+        }
+    }
+
+    double end_time = omp_get_wtime();
+    TILED_LU_RUNTIME[0] = end_time - start_time;
+    return info;
+}
+
+// Cholesky tasks
+// --------------
+/// Cholesky factorization of a diagonal tile (lower triangle only)
+void tile_cholesky(double* A, int nb, int k, int* info){
+    for (int c = 0; c < nb; c++) {
+        if (A[c * nb + c] <= 0.0) {
+            if (*info == 0)
+                *info = k * nb + c + 1;
+            return;
+        }
+        double d = sqrt(A[c * nb + c]);
+        A[c * nb + c] = d;
+        for (int r = c + 1; r < nb; r++)
+            A[r * nb + c] /= d;
+        for (int j = c + 1; j < nb; j++)
+            for (int r = j; r < nb; r++)
+                A[r * nb + j] -= A[r * nb + c] * A[j * nb + c];
+    }
+}
+
+/// B = B • inverse_of_transpose_of_L, where L is the lower triangle of the tile L
+void tile_lower_transpose_solve(const double* L, double* B, int nb){
+    for (int r = 0; r < nb; r++)
+        for (int c = 0; c < nb; c++) {
+            double v = B[r * nb + c];
+            for (int q = 0; q < c; q++)
+                v -= B[r * nb + q] * L[c * nb + q];
+            B[r * nb + c] = v / L[c * nb + c];
+        }
+}
+
+/**
+ * Tiled Cholesky factorization of the symmetric positive definite matrix held in tiles T. Only the lower tiles are read
+ * and written; on return they hold L (the upper triangles of the diagonal tiles are left unspecified).
+ * @return 0, 1 + the column where the matrix turned out not to be positive definite, or -1 if n is not a multiple of nb.
+ */
+int tiled_cholesky_factorization(double** T, int n, int nb, int number_of_threads){
+    if (n % nb != 0)
+        return -1;
+
+    int nt = n / nb;
+    int info = 0;
+    omp_set_num_threads(number_of_threads);
+    double start_time = omp_get_wtime();
+
+    #pragma omp parallel default(none) shared(T, nt, nb, info)
+    #pragma omp single
+    for (int k = 0; k < nt; k++) {
+        #pragma omp task default(none) shared(T, nt, nb, info) firstprivate(k) depend(inout: T[k * nt + k])
+        tile_cholesky(T[k * nt + k], nb, k, &info);
+
+        for (int i = k + 1; i < nt; i++) {
+            #pragma omp task default(none) shared(T, nt, nb) firstprivate(k, i) \
+                    depend(in: T[k * nt + k]) depend(inout: T[i * nt + k])
+            tile_lower_transpose_solve(T[k * nt + k], T[i * nt + k], nb);
+        }
+
+        for (int j = k + 1; j < nt; j++) {
+            for (int i = j; i < nt; i++) {
+                #pragma omp task default(none) shared(T, nt, nb) firstprivate(k, j, i) \
+                        depend(in: T[i * nt + k], T[j * nt + k]) depend(inout: T[i * nt + j])
+                tile_multiply_transpose_subtract(T[i * nt + k], T[j * nt + k], T[i * nt + j], nb);
+            }
+        }
+    }
+
+    double end_time = omp_get_wtime();
+    TILED_CHOLESKY_RUNTIME[0] = end_time - start_time;
+    return info;
+}
+
+// Functions to test the performance of each method
+// ------------------------------------------------
+double** allocate_test_matrix(arena* a, int n, int symmetric_positive_definite){
+    double** A = arena_alloc_matrix(a, n, n);
+    srand(1);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            A[i][j] = (double)rand() / RAND_MAX - 0.5;
+    if (symmetric_positive_definite) {
+        // Symmetric and strictly diagonally dominant with a positive diagonal, hence positive definite
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < i; j++)
+                A[i][j] = A[j][i];
+            A[i][i] = n;
+        }
+    }
+    return A;
+}
+
+void copy_matrix(double** from, double** to, int n){
+    for (int i = 0; i < n; i++)
+        memcpy(to[i], from[i], n * sizeof(double));
+}
+
+void sample_lu_factorization(int n, int nb, int number_of_trials, int number_of_threads){
+    arena matrices;
+    arena_init(&matrices, 0);
+    double** A = allocate_test_matrix(&matrices, n, 0);
+    double** LU_seq = arena_alloc_matrix(&matrices, n, n);
+    double** LU_tiled = arena_alloc_matrix(&matrices, n, n);
+    int* ipiv_seq = (int*)arena_alloc(&matrices, n * sizeof(int));
+    int* ipiv_tiled = (int*)arena_alloc(&matrices, n * sizeof(int));
+    double flops = 2.0 / 3.0 * n * (double)n * n;
+
+    double sequential_time = 0.0;
+    double tiled_time = 0.0;
+    for (int t = 0; t < number_of_trials; t++) {
+        copy_matrix(A, LU_seq, n);
+        sequential_lu_factorization(LU_seq, ipiv_seq, n);
+        sequential_time = sequential_time + SEQUENTIAL_LU_RUNTIME[0];
+
+        arena_mark mark = arena_get_mark(&matrices);
+        double** T = tile_matrix(&matrices, A, n, nb);
+        tiled_lu_factorization(T, ipiv_tiled, n, nb, number_of_threads);
+        tiled_time = tiled_time + TILED_LU_RUNTIME[0];
+        untile_matrix(T, LU_tiled, n, nb);
+        arena_release(&matrices, mark);
+    }
+
+    double difference = 0.0;
+    int same_pivots = 1;
+    for (int i = 0; i < n; i++) {
+        same_pivots = same_pivots && ipiv_seq[i] == ipiv_tiled[i];
+        for (int j = 0; j < n; j++)
+            difference = fmax(difference, fabs(LU_seq[i][j] - LU_tiled[i][j]));
+    }
+
+    sequential_time = sequential_time / (double)number_of_trials;
+    tiled_time = tiled_time / (double)number_of_trials;
+
+    printf("LU factorization with partial pivoting (n = %d, tile size %d, %d threads):\n", n, nb, number_of_threads);
+    printf("The SEQUENTIAL LU took on average: %f seconds (%.2f GFLOP/s)\n", sequential_time, flops / sequential_time * 1e-9);
+    printf("The TILED TASK LU took on average: %f seconds (%.2f GFLOP/s)\n", tiled_time, flops / tiled_time * 1e-9);
+    printf("Pivots %s, largest difference between the factors: %e\n\n\n", same_pivots ? "match" : "DIFFER", difference);
+
+    arena_destroy(&matrices);
+}
+
+void sample_cholesky_factorization(int n, int nb, int number_of_trials, int number_of_threads){
+    arena matrices;
+    arena_init(&matrices, 0);
+    double** A = allocate_test_matrix(&matrices, n, 1);
+    double** L_seq = arena_alloc_matrix(&matrices, n, n);
+    double** L_tiled = arena_alloc_matrix(&matrices, n, n);
+    double flops = 1.0 / 3.0 * n * (double)n * n;
+
+    double sequential_time = 0.0;
+    double tiled_time = 0.0;
+    for (int t = 0; t < number_of_trials; t++) {
+        copy_matrix(A, L_seq, n);
+        sequential_cholesky_factorization(L_seq, n);
+        sequential_time = sequential_time + SEQUENTIAL_CHOLESKY_RUNTIME[0];
+
+        arena_mark mark = arena_get_mark(&matrices);
+        double** T = tile_matrix(&matrices, A, n, nb);
+        tiled_cholesky_factorization(T, n, nb, number_of_threads);
+        tiled_time = tiled_time + TILED_CHOLESKY_RUNTIME[0];
+        untile_matrix(T, L_tiled, n, nb);
+        arena_release(&matrices, mark);
+    }
+
+    double difference = 0.0;
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j <= i; j++)
+            difference = fmax(difference, fabs(L_seq[i][j] - L_tiled[i][j]));
+
+    sequential_time = sequential_time / (double)number_of_trials;
+    tiled_time = tiled_time / (double)number_of_trials;
+
+    printf("Cholesky factorization (n = %d, tile size %d, %d threads):\n", n, nb, number_of_threads);
+    printf("The SEQUENTIAL Cholesky took on average: %f seconds (%.2f GFLOP/s)\n", sequential_time, flops / sequential_time * 1e-9);
+    printf("The TILED TASK Cholesky took on average: %f seconds (%.2f GFLOP/s)\n", tiled_time, flops / tiled_time * 1e-9);
+    printf("Largest difference between the factors: %e\n\n\n", difference);
+
+    arena_destroy(&matrices);
+}
+
+#endif //OPENMP_C_TUTORIAL_TILED_FACTORIZATION_H
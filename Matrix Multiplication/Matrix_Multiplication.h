@@ -1,9 +1,12 @@
+#ifndef OPENMP_C_TUTORIAL_MATRIX_MULTIPLICATION_H
+#define OPENMP_C_TUTORIAL_MATRIX_MULTIPLICATION_H
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <omp.h>
-#include "Matrix.h"
+#include "../Memory Arena/Arena_Allocator.h"
+#include "../Thread Pool/Thread_Pool.h"
 
 // Global variables to measure the runtime of the functions
 // --------------------------------------------------------
@@ -12,6 +15,7 @@ double COLLAPSE_MM_RUNTIME[1];
 double SEPARATE_PARALLEL_LOOPS_MM_RUNTIME[1];
 double REDUCTION_MM_RUNTIME[1];
 double TRANSPOSE_SPEEDUP_MM_RUNTIME[1];
+double THREAD_POOL_MM_RUNTIME[1];
 
 // Matrix Multiplication Functions
 // -------------------------------
@@ -93,7 +97,16 @@ double** parallel_matrix_multiplication_3(double** A, double** B, double** C, in
 // We can use the idea of multiplying by a transpose to speedup matrix multiplication
 double** transpose_speedup_matrix_multiplication(double** A, double** B, double** C, int n, int number_of_threads){
     omp_set_num_threads(number_of_threads);
-    double** B_transpose = transpose(B, n);
+
+    // The transpose is scratch space: draw it from the calling thread's arena so repeated calls do not allocate
+    arena* scratch = arena_local();
+    arena_mark mark = arena_get_mark(scratch);
+    double** B_transpose = arena_alloc_matrix(scratch, n, n);
+    #pragma omp parallel for collapse(2) default(none) shared(B, B_transpose, n)
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            B_transpose[j][i] = B[i][j];
+
     double start_time = omp_get_wtime();
     #pragma omp parallel for collapse(2) default(none) shared(A, C, B_transpose, n)
     for (int i = 0; i < n; i++){
@@ -107,10 +120,7 @@ double** transpose_speedup_matrix_multiplication(double** A, double** B, double*
     }
 
     // Free memory:
-    for (int i = 0; i < n; i++) {
-        free(B_transpose[i]);
-    }
-    free(B_transpose);
+    arena_release(scratch, mark);
 
     double end_time = omp_get_wtime();
     TRANSPOSE_SPEEDUP_MM_RUNTIME[0] = end_time - start_time;
@@ -118,10 +128,57 @@ double** transpose_speedup_matrix_multiplication(double** A, double** B, double*
 }
 
 
+typedef struct {
+    double** A;
+    double** B;
+    double** C;
+    int n;
+    int first_row;
+    int last_row;           // exclusive
+    thread_pool_future future;
+} matrix_rows_task;
+
+void multiply_matrix_rows(void* argument){
+    matrix_rows_task* task = (matrix_rows_task*)argument;
+    double** A = task->A;
+    double** B = task->B;
+    double** C = task->C;
+    int n = task->n;
+
+    // i-k-j order: the innermost loop walks rows of B and C, so no transpose is needed for unit-stride access
+    for (int i = task->first_row; i < task->last_row; i++) {
+        for (int j = 0; j < n; j++)
+            C[i][j] = 0.0;
+        for (int k = 0; k < n; k++) {
+            double a = A[i][k];
+            for (int j = 0; j < n; j++)
+                C[i][j] += a * B[k][j];
+        }
+    }
+}
+
+// Parallel MM by submitting blocks of rows of C to a persistent thread pool
+double** thread_pool_matrix_multiplication(thread_pool* pool, double** A, double** B, double** C, int n, int tasks){
+    double start_time = omp_get_wtime();
+    matrix_rows_task rows[tasks];
+
+    for (int t = 0; t < tasks; t++) {
+        rows[t].A = A; rows[t].B = B; rows[t].C = C; rows[t].n = n;
+        rows[t].first_row = (int)((long long)n * t / tasks);
+        rows[t].last_row = (int)((long long)n * (t + 1) / tasks);
+        thread_pool_submit(pool, &rows[t].future, multiply_matrix_rows, &rows[t]);
+    }
+    for (int t = 0; t < tasks; t++)
+        thread_pool_wait(pool, &rows[t].future);
+
+    double end_time = omp_get_wtime();
+    THREAD_POOL_MM_RUNTIME[0] = end_time - start_time;
+    return C;
+}
+
 // Returns the C = A • transpose_of_B
 double** parallel_matrix_transpose_multiplication(double** A, double** B, double** C, int n){
     double start_time = omp_get_wtime();
-    transpose(C, n);
     #pragma omp parallel for collapse(2) default(none) shared(n) shared(A) shared(B) shared(C)
     for (int i = 0; i < n; i++) {
         for (int j = 0; j < n; j++) {
@@ -212,3 +269,25 @@ void sample_transpose_speedup_matrix_multiplication(double** A, double** B, doub
 
     printf("The TRANSPOSE speedup MM took on average: %f seconds\n\n\n", total_time);
 }
+
+void sample_thread_pool_matrix_multiplication(double** A, double** B, double** C, int n, int tasks, int number_of_trials, int number_of_threads){
+    double total_time = 0.0;
+
+    thread_pool pool;
+    thread_pool_init(&pool, number_of_threads);
+
+    for (int i = 0; i < number_of_trials; i++){
+        thread_pool_matrix_multiplication(&pool, A, B, C, n, tasks);
+        total_time = total_time + THREAD_POOL_MM_RUNTIME[0];
+    }
+
+    thread_pool_destroy(&pool);
+
+    printf("Using a THREAD POOL:\n");
+
+    total_time = total_time / (double)number_of_trials;
+
+    printf("The THREAD POOL MM took on average: %f seconds\n\n\n", total_time);
+}
+
+#endif //OPENMP_C_TUTORIAL_MATRIX_MULTIPLICATION_H
@@ -0,0 +1,425 @@
+#ifndef OPENMP_C_TUTORIAL_MATRIX_VECTOR_H
+#define OPENMP_C_TUTORIAL_MATRIX_VECTOR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <unistd.h>
+#include <omp.h>
+#include "../Memory Arena/Arena_Allocator.h"
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#define MATRIX_VECTOR_STREAMING_STORES 1           // _mm_stream_pd is part of SSE2, so every x86-64 target has it
+#else
+#define MATRIX_VECTOR_STREAMING_STORES 0
+#endif
+
+/**
+ * Matrix-vector products and vector kernels for iterative solvers. Unlike matrix multiplication, every element these
+ * kernels load is used once or twice, so they are limited by memory bandwidth, not by arithmetic. They are written to
+ * move as few bytes as possible:
+ *
+ *  - Inner loops are `omp simd` loops, so a core loads whole vectors per instruction and keeps more requests to
+ *    memory in flight.
+ *  - Every kernel splits its index space into one contiguous block per thread with schedule(static). When the data is
+ *    initialized with vector_first_touch() / matrix_first_touch() and the same number of threads, each page is placed
+ *    on the NUMA node of the thread that later reads it.
+ *  - vector_triad() writes its output with non-temporal (streaming) stores, 32 bytes at a time with AVX and 16 bytes
+ *    with SSE2, so the output is not read into the cache before it is overwritten. This removes the write-allocate read, a quarter of the traffic of an
+ *    out-of-place kernel. The triad is the only kernel that streams. In-place updates such as axpy read their output
+ *    anyway, so there is no read for streaming stores to remove. The gemv kernels write one element per row or column
+ *    of the matrix, 1/n of their traffic, so streaming their outputs would save nothing measurable; they, too, use
+ *    ordinary stores.
+ *    sample_matrix_vector() times the triad both ways, since whether streaming stores win depends on the machine.
+ *  - The fused kernels compute two results from a single pass over the matrix: y = A·x and z = Aᵀ·w (the two products
+ *    of BiCG), or y = A·x and xᵀ·A·x (the matrix product and curvature of CG).
+ *
+ * Matrices use the double** layout of the rest of the module; rows need not be contiguous.
+ */
+
+#ifndef MATRIX_VECTOR_STREAMING_MIN
+#define MATRIX_VECTOR_STREAMING_MIN (1 << 18)       // below this many elements, outputs probably stay in cache anyway
+#endif
+
+// Global variables to measure the runtime of the functions
+// --------------------------------------------------------
+double GEMV_RUNTIME[1];
+double GEMV_TRANSPOSE_RUNTIME[1];
+double GEMV_FUSED_RUNTIME[1];
+double GEMV_DOT_RUNTIME[1];
+double DOT_RUNTIME[1];
+double AXPY_RUNTIME[1];
+double NRM2_RUNTIME[1];
+double TRIAD_RUNTIME[1];
+
+// First touch
+// -----------
+// The unit of placement is the page that backs the memory. Arenas map their blocks with transparent huge pages, so data
+// drawn from an arena is placed in 2 MB pages: a page goes to the node of the thread that touches it first, and a
+// thread whose block of rows or elements is smaller than a huge page shares that page's node with its neighbours.
+// Placement is therefore only as fine as 2 MB (e.g. about 65 rows of a 4000 x 4000 matrix), not 4 KB. Blocks of
+// several huge pages per thread are placed as intended.
+
+/// Zeroes v[0, n) with the static schedule used by the kernels below, so every page lands near the thread that uses it
+void vector_first_touch(double* v, int n, int number_of_threads){
+    #pragma omp parallel for num_threads(number_of_threads) schedule(static) default(none) shared(v, n)
+    for (int i = 0; i < n; i++)
+        v[i] = 0.0;
+}
+
+/// Zeroes the rows of A with the row distribution used by the kernels below
+void matrix_first_touch(double** A, int rows, int cols, int number_of_threads){
+    #pragma omp parallel for num_threads(number_of_threads) schedule(static) default(none) shared(A, rows, cols)
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < cols; j++)
+            A[i][j] = 0.0;
+}
+
+// Vector kernels
+// --------------
+static inline double row_dot(const double* a, const double* x, int n){
+    double sum = 0.0;
+    #pragma omp simd reduction(+:sum)
+    for (int j = 0; j < n; j++)
+        sum += a[j] * x[j];
+    return sum;
+}
+
+/// Returns x·y
+double vector_dot(const double* x, const double* y, int n, int number_of_threads){
+    double start_time = omp_get_wtime();
+    double sum = 0.0;
+    #pragma omp parallel for simd num_threads(number_of_threads) schedule(static) default(none) shared(x, y, n) \
+            reduction(+:sum)
+    for (int i = 0; i < n; i++)
+        sum += x[i] * y[i];
+    DOT_RUNTIME[0] = omp_get_wtime() - start_time;
+    return sum;
+}
+
+/// y = alpha·x + y
+void vector_axpy(double alpha, const double* x, double* y, int n, int number_of_threads){
+    double start_time = omp_get_wtime();
+    #pragma omp parallel for simd num_threads(number_of_threads) schedule(static) default(none) shared(alpha, x, y, n)
+    for (int i = 0; i < n; i++)
+        y[i] += alpha * x[i];
+    AXPY_RUNTIME[0] = omp_get_wtime() - start_time;
+}
+
+/// Returns the Euclidean norm of x. The squares are summed unscaled, so entries beyond about 1e154 overflow.
+double vector_nrm2(const double* x, int n, int number_of_threads){
+    double start_time = omp_get_wtime();
+    double sum = 0.0;
+    #pragma omp parallel for simd num_threads(number_of_threads) schedule(static) default(none) shared(x, n) \
+            reduction(+:sum)
+    for (int i = 0; i < n; i++)
+        sum += x[i] * x[i];
+    NRM2_RUNTIME[0] = omp_get_wtime() - start_time;
+    return sqrt(sum);
+}
+
+/// z[begin, end) = x + alpha·y, with streaming stores for the aligned part of z (32 bytes with AVX, 16 with SSE2)
+static void vector_triad_block(double* z, const double* x, const double* y, double alpha, int begin, int end,
+                               int streaming){
+    int i = begin;
+#if defined(__AVX__)
+    if (streaming) {
+        for (; i < end && ((uintptr_t)(z + i) & 31) != 0; i++)
+            z[i] = x[i] + alpha * y[i];
+        __m256d a = _mm256_set1_pd(alpha);
+        for (; i + 4 <= end; i += 4) {
+            __m256d v = _mm256_add_pd(_mm256_loadu_pd(x + i), _mm256_mul_pd(a, _mm256_loadu_pd(y + i)));
+            _mm256_stream_pd(z + i, v);
+        }
+        _mm_sfence();           // streaming stores are weakly ordered; make them visible before the caller reads z
+    }
+#elif defined(__SSE2__)
+    if (streaming) {
+        for (; i < end && ((uintptr_t)(z + i) & 15) != 0; i++)
+            z[i] = x[i] + alpha * y[i];
+        __m128d a = _mm_set1_pd(alpha);
+        for (; i + 2 <= end; i += 2) {
+            __m128d v = _mm_add_pd(_mm_loadu_pd(x + i), _mm_mul_pd(a, _mm_loadu_pd(y + i)));
+            _mm_stream_pd(z + i, v);
+        }
+        _mm_sfence();
+    }
+#else
+    (void)streaming;
+#endif
+    #pragma omp simd
+    for (int j = i; j < end; j++)
+        z[j] = x[j] + alpha * y[j];
+}
+
+/**
+ * z = x + alpha·y with streaming stores for z if streaming is non-zero and the target has them
+ * (MATRIX_VECTOR_STREAMING_STORES), ordinary stores otherwise
+ */
+void vector_triad_stores(double* z, const double* x, const double* y, double alpha, int n, int streaming,
+                         int number_of_threads){
+    double start_time = omp_get_wtime();
+    #pragma omp parallel num_threads(number_of_threads) default(none) shared(z, x, y, alpha, n, streaming)
+    {
+        int t = omp_get_thread_num();
+        int threads = omp_get_num_threads();
+        int begin = (int)((long long)n * t / threads);
+        int end = (int)((long long)n * (t + 1) / threads);
+        vector_triad_block(z, x, y, alpha, begin, end, streaming);
+    }
+    TRIAD_RUNTIME[0] = omp_get_wtime() - start_time;
+}
+
+/**
+ * z = x + alpha·y, the STREAM triad. It is also the reference bandwidth for the other kernels: it moves 24 bytes per
+ * element with no reuse at all, from three separate streams. Kernels with fewer streams, such as axpy, which updates y
+ * in place, can run faster than it.
+ */
+void vector_triad(double* z, const double* x, const double* y, double alpha, int n, int number_of_threads){
+    vector_triad_stores(z, x, y, alpha, n, n >= MATRIX_VECTOR_STREAMING_MIN, number_of_threads);
+}
+
+// Matrix-vector kernels
+// ---------------------
+/**
+ * y = alpha·A·x + beta·y for a rows x cols matrix A. Each thread computes a block of y from the rows of A it owns;
+ * every row is one unit-stride dot product.
+ */
+void gemv(double alpha, double** A, const double* x, double beta, double* y, int rows, int cols, int number_of_threads){
+    double start_time = omp_get_wtime();
+    #pragma omp parallel for num_threads(number_of_threads) schedule(static) default(none) \
+            shared(alpha, A, x, beta, y, rows, cols)
+    for (int i = 0; i < rows; i++) {
+        double v = alpha * row_dot(A[i], x, cols);
+        y[i] = beta == 0.0 ? v : v + beta * y[i];
+    }
+    GEMV_RUNTIME[0] = omp_get_wtime() - start_time;
+}
+
+/**
+ * y = alpha·Aᵀ·x + beta·y for a rows x cols matrix A, without a transpose. Reading A by columns would touch a new cache
+ * line for every element, so each thread instead streams its own rows of A and adds x[i]·A[i] to a private partial
+ * result of length cols; the partials are then summed by columns. The partials come from arena_local(), so only the
+ * first call of a thread allocates them.
+ */
+void gemv_transpose(double alpha, double** A, const double* x, double beta, double* y, int rows, int cols,
+                    int number_of_threads){
+    double start_time = omp_get_wtime();
+    // The partials are scratch space: draw them from the calling thread's arena so repeated calls do not allocate
+    arena* scratch = arena_local();
+    arena_mark mark = arena_get_mark(scratch);
+    double* partials = (double*)arena_alloc(scratch, (size_t)number_of_threads * cols * sizeof(double));
+    int threads_used = 1;
+
+    #pragma omp parallel num_threads(number_of_threads) default(none) \
+            shared(alpha, A, x, beta, y, rows, cols, partials, threads_used)
+    {
+        int t = omp_get_thread_num();
+        #pragma omp single nowait
+        threads_used = omp_get_num_threads();
+
+        double* partial = partials + (size_t)t * cols;
+        #pragma omp simd
+        for (int j = 0; j < cols; j++)
+            partial[j] = 0.0;
+
+        #pragma omp for schedule(static)
+        for (int i = 0; i < rows; i++) {
+            const double* a = A[i];
+            double xi = x[i];
+            #pragma omp simd
+            for (int j = 0; j < cols; j++)
+                partial[j] += xi * a[j];
+        }
+        // the implicit barrier of the loop above makes every partial complete
+
+        #pragma omp for schedule(static)
+        for (int j = 0; j < cols; j++) {
+            double v = 0.0;
+            for (int u = 0; u < threads_used; u++)
+                v += partials[(size_t)u * cols + j];
+            v *= alpha;
+            y[j] = beta == 0.0 ? v : v + beta * y[j];
+        }
+    }
+
+    arena_release(scratch, mark);
+    GEMV_TRANSPOSE_RUNTIME[0] = omp_get_wtime() - start_time;
+}
+
+/**
+ * y = A·x and z = Aᵀ·w in a single pass over A: while a row of A is in cache, it is used for one element of y and for
+ * one update of the partial z. Half the matrix traffic of calling gemv() and gemv_transpose().
+ */
+void gemv_fused(double** A, const double* x, double* y, const double* w, double* z, int rows, int cols,
+                int number_of_threads){
+    double start_time = omp_get_wtime();
+    // The partials are scratch space: draw them from the calling thread's arena so repeated calls do not allocate
+    arena* scratch = arena_local();
+    arena_mark mark = arena_get_mark(scratch);
+    double* partials = (double*)arena_alloc(scratch, (size_t)number_of_threads * cols * sizeof(double));
+    int threads_used = 1;
+
+    #pragma omp parallel num_threads(number_of_threads) default(none) \
+            shared(A, x, y, w, z, rows, cols, partials, threads_used)
+    {
+        int t = omp_get_thread_num();
+        #pragma omp single nowait
+        threads_used = omp_get_num_threads();
+
+        double* partial = partials + (size_t)t * cols;
+        #pragma omp simd
+        for (int j = 0; j < cols; j++)
+            partial[j] = 0.0;
+
+        #pragma omp for schedule(static)
+        for (int i = 0; i < rows; i++) {
+            const double* a = A[i];
+            double wi = w[i];
+            double sum = 0.0;
+            #pragma omp simd reduction(+:sum)
+            for (int j = 0; j < cols; j++) {
+                sum += a[j] * x[j];
+                partial[j] += wi * a[j];
+            }
+            y[i] = sum;
+        }
+
+        #pragma omp for schedule(static)
+        for (int j = 0; j < cols; j++) {
+            double v = 0.0;
+            for (int u = 0; u < threads_used; u++)
+                v += partials[(size_t)u * cols + j];
+            z[j] = v;
+        }
+    }
+
+    arena_release(scratch, mark);
+    GEMV_FUSED_RUNTIME[0] = omp_get_wtime() - start_time;
+}
+
+/**
+ * y = A·x for a square n x n matrix and returns xᵀ·y, the curvature p·A·p of conjugate gradients, without reading y
+ * back: each y[i] is multiplied by x[i] while it is still in a register.
+ */
+double gemv_dot(double** A, const double* x, double* y, int n, int number_of_threads){
+    double start_time = omp_get_wtime();
+    double curvature = 0.0;
+    #pragma omp parallel for num_threads(number_of_threads) schedule(static) default(none) shared(A, x, y, n) \
+            reduction(+:curvature)
+    for (int i = 0; i < n; i++) {
+        double v = row_dot(A[i], x, n);
+        y[i] = v;
+        curvature += x[i] * v;
+    }
+    GEMV_DOT_RUNTIME[0] = omp_get_wtime() - start_time;
+    return curvature;
+}
+
+// Function to test the performance of the method
+// ----------------------------------------------
+static void print_bandwidth(const char* name, double bytes, double seconds, double peak){
+    double gigabytes_per_second = bytes / seconds / 1e9;
+    printf("%-28s %f seconds, %7.2f GB/s (%5.1f%% of the triad)\n", name, seconds, gigabytes_per_second,
+           100.0 * gigabytes_per_second / peak);
+}
+
+/**
+ * Runs every kernel on an n x n matrix and vectors of length vector_length (both should be well beyond the last level
+ * cache) and reports the bandwidth each one achieves, relative to the faster of the two STREAM triads measured on the
+ * same data. On targets without streaming stores, only the triad with ordinary stores is run. The byte counts are the minimum traffic of each kernel: every input read once and every output written
+ * once. The results of the fused gemv are checked against separate calls of gemv() and gemv_transpose().
+ */
+void sample_matrix_vector(int n, int vector_length, int number_of_trials, int number_of_threads){
+    arena memory;
+    arena_init(&memory, 0);
+    double** A = arena_alloc_matrix(&memory, n, n);
+    double* x = (double*)arena_alloc(&memory, (size_t)vector_length * sizeof(double));
+    double* y = (double*)arena_alloc(&memory, (size_t)vector_length * sizeof(double));
+    double* z = (double*)arena_alloc(&memory, (size_t)vector_length * sizeof(double));
+    double* w = (double*)arena_alloc(&memory, (size_t)vector_length * sizeof(double));
+    double* y_check = (double*)arena_alloc(&memory, (size_t)n * sizeof(double));
+    double* z_check = (double*)arena_alloc(&memory, (size_t)n * sizeof(double));
+
+    matrix_first_touch(A, n, n, number_of_threads);
+    vector_first_touch(x, vector_length, number_of_threads);
+    vector_first_touch(y, vector_length, number_of_threads);
+    vector_first_touch(z, vector_length, number_of_threads);
+    vector_first_touch(w, vector_length, number_of_threads);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            A[i][j] = 1.0 / (1.0 + i + j);
+    for (int i = 0; i < vector_length; i++) {
+        x[i] = 1.0 + i % 7;
+        y[i] = 1.0;
+        w[i] = 2.0 - i % 3;
+    }
+
+    double t[9] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    double checksum = 0.0;
+    for (int trial = 0; trial < number_of_trials; trial++) {
+        if (MATRIX_VECTOR_STREAMING_STORES) {
+            vector_triad_stores(z, x, y, 0.5, vector_length, 1, number_of_threads);
+            t[0] += TRIAD_RUNTIME[0];
+        }
+        vector_triad_stores(z, x, y, 0.5, vector_length, 0, number_of_threads);
+        t[8] += TRIAD_RUNTIME[0];
+        checksum += vector_dot(x, y, vector_length, number_of_threads);
+        t[1] += DOT_RUNTIME[0];
+        vector_axpy(1e-3, x, y, vector_length, number_of_threads);
+        t[2] += AXPY_RUNTIME[0];
+        checksum += vector_nrm2(x, vector_length, number_of_threads);
+        t[3] += NRM2_RUNTIME[0];
+        gemv(1.0, A, x, 0.0, y, n, n, number_of_threads);
+        t[4] += GEMV_RUNTIME[0];
+        gemv_transpose(1.0, A, w, 0.0, z, n, n, number_of_threads);
+        t[5] += GEMV_TRANSPOSE_RUNTIME[0];
+        gemv_fused(A, x, y, w, z, n, n, number_of_threads);
+        t[6] += GEMV_FUSED_RUNTIME[0];
+        checksum += gemv_dot(A, x, y, n, number_of_threads);
+        t[7] += GEMV_DOT_RUNTIME[0];
+    }
+    for (int k = 0; k < 9; k++)
+        t[k] /= number_of_trials;
+
+    // The fused gemv must produce what the two separate products produce, up to the order of the additions
+    gemv(1.0, A, x, 0.0, y_check, n, n, number_of_threads);
+    gemv_transpose(1.0, A, w, 0.0, z_check, n, n, number_of_threads);
+    gemv_fused(A, x, y, w, z, n, n, number_of_threads);
+    double largest_error = 0.0;
+    for (int i = 0; i < n; i++) {
+        double error_y = fabs(y[i] - y_check[i]) / fmax(1.0, fabs(y_check[i]));
+        double error_z = fabs(z[i] - z_check[i]) / fmax(1.0, fabs(z_check[i]));
+        largest_error = fmax(largest_error, fmax(error_y, error_z));
+    }
+
+    double v = 8.0 * vector_length;         // bytes of one vector
+    double m = 8.0 * n * (double)n;         // bytes of the matrix
+    double best_triad = MATRIX_VECTOR_STREAMING_STORES && t[0] < t[8] ? t[0] : t[8];
+    double peak = 3.0 * v / best_triad / 1e9;
+
+    printf("Bandwidth of the MATRIX-VECTOR kernels (%d x %d matrix, vectors of %d, %d threads):\n", n, n,
+           vector_length, number_of_threads);
+    if (MATRIX_VECTOR_STREAMING_STORES)
+        print_bandwidth("triad (streaming stores)", 3.0 * v, t[0], peak);
+    else
+        printf("%-28s not available on this target\n", "triad (streaming stores)");
+    print_bandwidth("triad (ordinary stores)", 3.0 * v, t[8], peak);
+    print_bandwidth("dot", 2.0 * v, t[1], peak);
+    print_bandwidth("axpy", 3.0 * v, t[2], peak);
+    print_bandwidth("nrm2", v, t[3], peak);
+    print_bandwidth("gemv", m + 16.0 * n, t[4], peak);
+    print_bandwidth("gemv transpose", m + 16.0 * n, t[5], peak);
+    print_bandwidth("gemv fused (A*x and A^T*w)", m + 32.0 * n, t[6], peak);
+    print_bandwidth("gemv + dot (A*x and x^T*A*x)", m + 16.0 * n, t[7], peak);
+    printf("The fused gemv took %.2f times as long as gemv and gemv transpose together (checksum %g)\n",
+           t[6] / (t[4] + t[5]), checksum);
+    printf("Largest relative difference between the fused and the separate gemv: %e%s\n\n\n", largest_error,
+           largest_error <= 1e-12 ? "" : " (WRONG RESULT)");
+
+    arena_destroy(&memory);
+}
+
+#endif //OPENMP_C_TUTORIAL_MATRIX_VECTOR_H
@@ -0,0 +1,308 @@
+#ifndef OPENMP_C_TUTORIAL_SUMMA_MPI_H
+#define OPENMP_C_TUTORIAL_SUMMA_MPI_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <mpi.h>
+#include <omp.h>
+#include "Tile_Kernels.h"
+
+/**
+ * Distributed-memory matrix multiplication with SUMMA (Scalable Universal Matrix Multiplication Algorithm, van de Geijn
+ * and Watts). The processes form a 2D grid and every matrix is distributed block-cyclically over it, as in ScaLAPACK:
+ * block (I, J) of size block x block lives on process (I mod grid_rows, J mod grid_cols). This is a hybrid MPI + OpenMP
+ * code: MPI moves panels between processes, and each process updates its local part of C with an OpenMP parallel loop.
+ *
+ * For every block column k of A (and block row k of B), the process column that owns it broadcasts its part of the
+ * panel along each process row, the process row that owns the block row of B broadcasts along each process column,
+ * and every process adds the product of the two panels to its local part of C. The broadcasts of step k + 1 are
+ * started with non-blocking collectives before the local update of step k, so communication overlaps computation.
+ * How much overlap is achieved depends on the MPI library progressing the broadcasts in the background.
+ *
+ * Build and run on a single host with, e.g.:
+ *     mpicc -O2 -fopenmp Test_SUMMA.c -o summa && mpirun -np 4 ./summa 1024 64
+ */
+
+// Global variable to measure the runtime of the multiplication
+// ------------------------------------------------------------
+double SUMMA_MM_RUNTIME[1];
+
+#define SUMMA_ROW_BLOCK 16          // rows of the local C updated by one call to the panel kernel
+
+typedef struct {
+    MPI_Comm grid;
+    MPI_Comm row;               // the processes of my process row, ranked by process column
+    MPI_Comm column;            // the processes of my process column, ranked by process row
+    int grid_rows, grid_cols;
+    int my_row, my_col;
+    int n;                      // global matrix size
+    int block;                  // block size of the block-cyclic distribution
+    int local_rows, local_cols;
+} summa_grid;
+
+/**
+ * The number of rows (or columns) of a block-cyclically distributed dimension of size n owned by process index p of
+ * number_of_processes (ScaLAPACK's NUMROC).
+ */
+int summa_local_size(int n, int block, int p, int number_of_processes){
+    int blocks = n / block;
+    int size = (blocks / number_of_processes) * block;
+    int extra = blocks % number_of_processes;
+    if (p < extra)
+        size += block;
+    else if (p == extra)
+        size += n % block;
+    return size;
+}
+
+/// The global index of local index l of process index p
+int summa_global_index(int l, int block, int p, int number_of_processes){
+    return ((l / block) * number_of_processes + p) * block + l % block;
+}
+
+/**
+ * Arranges the processes of comm into a 2D grid that is as square as possible and computes the shape of the local
+ * parts of an n x n matrix distributed in block x block blocks.
+ */
+void summa_grid_create(summa_grid* g, MPI_Comm comm, int n, int block){
+    int size;
+    int dims[2] = {0, 0};
+    int periods[2] = {0, 0};
+    int coords[2];
+    int keep_cols[2] = {0, 1};
+    int keep_rows[2] = {1, 0};
+
+    MPI_Comm_size(comm, &size);
+    MPI_Dims_create(size, 2, dims);
+    MPI_Cart_create(comm, 2, dims, periods, 0, &g->grid);
+
+    int rank;
+    MPI_Comm_rank(g->grid, &rank);
+    MPI_Cart_coords(g->grid, rank, 2, coords);
+    MPI_Cart_sub(g->grid, keep_cols, &g->row);
+    MPI_Cart_sub(g->grid, keep_rows, &g->column);
+
+    g->grid_rows = dims[0];
+    g->grid_cols = dims[1];
+    g->my_row = coords[0];
+    g->my_col = coords[1];
+    g->n = n;
+    g->block = block;
+    g->local_rows = summa_local_size(n, block, g->my_row, g->grid_rows);
+    g->local_cols = summa_local_size(n, block, g->my_col, g->grid_cols);
+}
+
+void summa_grid_free(summa_grid* g){
+    MPI_Comm_free(&g->row);
+    MPI_Comm_free(&g->column);
+    MPI_Comm_free(&g->grid);
+}
+
+/// Allocates the local part of a distributed matrix (row-major, local_rows x local_cols)
+double* summa_alloc_local(const summa_grid* g){
+    size_t elements = (size_t)g->local_rows * g->local_cols;
+    return (double*)calloc(elements > 0 ? elements : 1, sizeof(double));
+}
+
+/**
+ * Sends the parts of the n x n matrix M held by process 0 of the grid to their owners. M is only read on process 0.
+ */
+void summa_distribute(const summa_grid* g, double** M, double* local){
+    int rank, size;
+    MPI_Comm_rank(g->grid, &rank);
+    MPI_Comm_size(g->grid, &size);
+
+    double* packed = NULL;
+    int* counts = NULL;
+    int* displacements = NULL;
+
+    if (rank == 0) {
+        packed = (double*)malloc((size_t)g->n * g->n * sizeof(double));
+        counts = (int*)malloc(size * sizeof(int));
+        displacements = (int*)malloc(size * sizeof(int));
+
+        int offset = 0;
+        for (int r = 0; r < size; r++) {
+            int coords[2];
+            MPI_Cart_coords(g->grid, r, 2, coords);
+            int rows = summa_local_size(g->n, g->block, coords[0], g->grid_rows);
+            int cols = summa_local_size(g->n, g->block, coords[1], g->grid_cols);
+            for (int i = 0; i < rows; i++) {
+                int gi = summa_global_index(i, g->block, coords[0], g->grid_rows);
+                for (int j = 0; j < cols; j++)
+                    packed[offset + i * cols + j] = M[gi][summa_global_index(j, g->block, coords[1], g->grid_cols)];
+            }
+            counts[r] = rows * cols;
+            displacements[r] = offset;
+            offset += rows * cols;
+        }
+    }
+
+    MPI_Scatterv(packed, counts, displacements, MPI_DOUBLE, local, g->local_rows * g->local_cols, MPI_DOUBLE, 0,
+                 g->grid);
+
+    free(packed);
+    free(counts);
+    free(displacements);
+}
+
+/**
+ * Assembles the n x n matrix M on process 0 of the grid from the local parts of all processes. M is only written on
+ * process 0.
+ */
+void summa_collect(const summa_grid* g, const double* local, double** M){
+    int rank, size;
+    MPI_Comm_rank(g->grid, &rank);
+    MPI_Comm_size(g->grid, &size);
+
+    double* packed = NULL;
+    int* counts = NULL;
+    int* displacements = NULL;
+
+    if (rank == 0) {
+        packed = (double*)malloc((size_t)g->n * g->n * sizeof(double));
+        counts = (int*)malloc(size * sizeof(int));
+        displacements = (int*)malloc(size * sizeof(int));
+
+        int offset = 0;
+        for (int r = 0; r < size; r++) {
+            int coords[2];
+            MPI_Cart_coords(g->grid, r, 2, coords);
+            counts[r] = summa_local_size(g->n, g->block, coords[0], g->grid_rows)
+                      * summa_local_size(g->n, g->block, coords[1], g->grid_cols);
+            displacements[r] = offset;
+            offset += counts[r];
+        }
+    }
+
+    MPI_Gatherv(local, g->local_rows * g->local_cols, MPI_DOUBLE, packed, counts, displacements, MPI_DOUBLE, 0,
+                g->grid);
+
+    if (rank == 0) {
+        for (int r = 0; r < size; r++) {
+            int coords[2];
+            MPI_Cart_coords(g->grid, r, 2, coords);
+            int rows = summa_local_size(g->n, g->block, coords[0], g->grid_rows);
+            int cols = summa_local_size(g->n, g->block, coords[1], g->grid_cols);
+            for (int i = 0; i < rows; i++) {
+                int gi = summa_global_index(i, g->block, coords[0], g->grid_rows);
+                for (int j = 0; j < cols; j++)
+                    M[gi][summa_global_index(j, g->block, coords[1], g->grid_cols)] = packed[displacements[r] + i * cols + j];
+            }
+        }
+    }
+
+    free(packed);
+    free(counts);
+    free(displacements);
+}
+
+/**
+ * C += A_panel • B_panel on the local part of C, where A_panel is rows x width and B_panel is width x cols. Rows of C
+ * are split among the OpenMP threads in blocks of SUMMA_ROW_BLOCK, and each block is one call to the sequential panel
+ * kernel of Tile_Kernels.h, which the tiled factorizations use for their trailing updates too.
+ */
+void summa_local_update(const double* A_panel, const double* B_panel, double* C, int rows, int cols, int width){
+    #pragma omp parallel for schedule(static) default(none) shared(A_panel, B_panel, C, rows, cols, width)
+    for (int first = 0; first < rows; first += SUMMA_ROW_BLOCK) {
+        int count = rows - first < SUMMA_ROW_BLOCK ? rows - first : SUMMA_ROW_BLOCK;
+        panel_multiply_accumulate(A_panel + (size_t)first * width, B_panel, C + (size_t)first * cols, count, cols,
+                                  width, 1.0);
+    }
+}
+
+/// Starts the broadcasts of panel step k into the given buffers
+static void summa_start_panels(const summa_grid* g, const double* A, const double* B, int k,
+                               double* A_panel, double* B_panel, MPI_Request requests[2]){
+    int width = g->n - k * g->block < g->block ? g->n - k * g->block : g->block;
+    int owner_col = k % g->grid_cols;
+    int owner_row = k % g->grid_rows;
+
+    // Block column k of A is not contiguous in the local row-major layout, so its owners pack it
+    if (g->my_col == owner_col) {
+        int offset = (k / g->grid_cols) * g->block;
+        for (int i = 0; i < g->local_rows; i++)
+            memcpy(A_panel + (size_t)i * width, A + (size_t)i * g->local_cols + offset, width * sizeof(double));
+    }
+    // Block row k of B is
+    if (g->my_row == owner_row) {
+        int offset = (k / g->grid_rows) * g->block;
+        memcpy(B_panel, B + (size_t)offset * g->local_cols, (size_t)width * g->local_cols * sizeof(double));
+    }
+
+    MPI_Ibcast(A_panel, g->local_rows * width, MPI_DOUBLE, owner_col, g->row, &requests[0]);
+    MPI_Ibcast(B_panel, width * g->local_cols, MPI_DOUBLE, owner_row, g->column, &requests[1]);
+}
+
+/**
+ * C = A • B for n x n matrices distributed block-cyclically over the grid. A, B and C are the local parts of the
+ * matrices (see summa_alloc_local()). Must be called by every process of the grid.
+ */
+void summa_matrix_multiplication(const summa_grid* g, const double* A, const double* B, double* C, int number_of_threads){
+    omp_set_num_threads(number_of_threads);
+    MPI_Barrier(g->grid);
+    double start_time = MPI_Wtime();
+
+    int steps = (g->n + g->block - 1) / g->block;
+    size_t A_panel_size = (size_t)g->local_rows * g->block;
+    size_t B_panel_size = (size_t)g->block * g->local_cols;
+
+    // Two panels of each kind: one being received while the other one is multiplied
+    double* A_panels[2];
+    double* B_panels[2];
+    for (int b = 0; b < 2; b++) {
+        A_panels[b] = (double*)malloc((A_panel_size > 0 ? A_panel_size : 1) * sizeof(double));
+        B_panels[b] = (double*)malloc((B_panel_size > 0 ? B_panel_size : 1) * sizeof(double));
+    }
+
+    memset(C, 0, (size_t)g->local_rows * g->local_cols * sizeof(double));
+
+    MPI_Request requests[2];
+    summa_start_panels(g, A, B, 0, A_panels[0], B_panels[0], requests);
+
+    for (int k = 0; k < steps; k++) {
+        int width = g->n - k * g->block < g->block ? g->n - k * g->block : g->block;
+        MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+
+        if (k + 1 < steps)
+            summa_start_panels(g, A, B, k + 1, A_panels[(k + 1) % 2], B_panels[(k + 1) % 2], requests);
+
+        summa_local_update(A_panels[k % 2], B_panels[k % 2], C, g->local_rows, g->local_cols, width);
+    }
+
+    for (int b = 0; b < 2; b++) {
+        free(A_panels[b]);
+        free(B_panels[b]);
+    }
+
+    MPI_Barrier(g->grid);
+    double end_time = MPI_Wtime();
+    SUMMA_MM_RUNTIME[0] = end_time - start_time;
+}
+
+// Function to test the performance of the method
+// ----------------------------------------------
+void sample_summa_matrix_multiplication(const summa_grid* g, const double* A, const double* B, double* C,
+                                        int number_of_trials, int number_of_threads){
+    double total_time = 0.0;
+    int rank;
+    MPI_Comm_rank(g->grid, &rank);
+
+    for (int i = 0; i < number_of_trials; i++){
+        summa_matrix_multiplication(g, A, B, C, number_of_threads);
+        total_time = total_time + SUMMA_MM_RUNTIME[0];
+    }
+
+    total_time = total_time / (double)number_of_trials;
+
+    if (rank == 0) {
+        printf("Using SUMMA on a %d x %d process grid (block size %d, %d threads per process):\n",
+               g->grid_rows, g->grid_cols, g->block, number_of_threads);
+        printf("The SUMMA MM took on average: %f seconds (%.2f GFLOP/s)\n\n\n", total_time,
+               2.0 * g->n * (double)g->n * g->n / total_time * 1e-9);
+    }
+}
+
+#endif //OPENMP_C_TUTORIAL_SUMMA_MPI_H
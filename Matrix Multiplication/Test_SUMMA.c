@@ -0,0 +1,61 @@
+#include "SUMMA_MPI.h"
+
+// Integer-valued entries keep every product exact, so the distributed result can be compared for equality
+double A_entry(int i, int j){ return (double)((i + 2 * j) % 7 - 3); }
+double B_entry(int i, int j){ return (double)((3 * i + j) % 5 - 2); }
+
+int main(int argc, char** argv) {
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+
+    int n = argc > 1 ? atoi(argv[1]) : 512;
+    int block = argc > 2 ? atoi(argv[2]) : 64;
+    int number_of_threads = argc > 3 ? atoi(argv[3]) : omp_get_max_threads();
+
+    summa_grid g;
+    summa_grid_create(&g, MPI_COMM_WORLD, n, block);
+
+    double* A = summa_alloc_local(&g);
+    double* B = summa_alloc_local(&g);
+    double* C = summa_alloc_local(&g);
+
+    // Every process generates its own blocks, so no process ever holds a whole matrix
+    for (int i = 0; i < g.local_rows; i++) {
+        int gi = summa_global_index(i, block, g.my_row, g.grid_rows);
+        for (int j = 0; j < g.local_cols; j++) {
+            int gj = summa_global_index(j, block, g.my_col, g.grid_cols);
+            A[i * g.local_cols + j] = A_entry(gi, gj);
+            B[i * g.local_cols + j] = B_entry(gi, gj);
+        }
+    }
+
+    sample_summa_matrix_multiplication(&g, A, B, C, 5, number_of_threads);
+
+    // Check the local part of C against the definition of the product
+    long long wrong = 0;
+    for (int i = 0; i < g.local_rows; i++) {
+        int gi = summa_global_index(i, block, g.my_row, g.grid_rows);
+        for (int j = 0; j < g.local_cols; j++) {
+            int gj = summa_global_index(j, block, g.my_col, g.grid_cols);
+            double expected = 0.0;
+            for (int k = 0; k < n; k++)
+                expected += A_entry(gi, k) * B_entry(k, gj);
+            if (C[i * g.local_cols + j] != expected)
+                wrong++;
+        }
+    }
+
+    long long total_wrong = 0;
+    MPI_Reduce(&wrong, &total_wrong, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (rank == 0)
+        printf("%lld wrong entries in the %d x %d product\n", total_wrong, n, n);
+
+    free(A); free(B); free(C);
+    summa_grid_free(&g);
+    MPI_Finalize();
+
+    return total_wrong == 0 ? 0 : 1;
+}
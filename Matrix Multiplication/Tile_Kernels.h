@@ -0,0 +1,48 @@
+#ifndef OPENMP_C_TUTORIAL_TILE_KERNELS_H
+#define OPENMP_C_TUTORIAL_TILE_KERNELS_H
+
+#include <stddef.h>
+
+// Tile kernels
+// ------------
+// Building blocks for tiled algorithms (e.g. the factorizations in Linear Systems/). A tile is a contiguous nb x nb
+// row-major block (a panel is a contiguous rectangular one); these kernels are sequential because the tiled algorithms
+// run one of them per task. The header only depends on the C standard library, so the tiled algorithms can use it
+// without the rest of Matrix_Multiplication.h.
+
+// C = C + alpha · A • B for a rows x width panel A, a width x cols panel B and a rows x cols panel C. The i-k-j loop
+// order keeps the innermost loop on contiguous rows of B and C.
+void panel_multiply_accumulate(const double* A, const double* B, double* C, int rows, int cols, int width,
+                               double alpha){
+    for (int i = 0; i < rows; i++) {
+        double* C_row = C + (size_t)i * cols;
+        for (int k = 0; k < width; k++) {
+            double a = alpha * A[(size_t)i * width + k];
+            const double* B_row = B + (size_t)k * cols;
+            for (int j = 0; j < cols; j++)
+                C_row[j] += a * B_row[j];
+        }
+    }
+}
+
+// C = C - A • B
+void tile_multiply_subtract(const double* A, const double* B, double* C, int nb){
+    panel_multiply_accumulate(A, B, C, nb, nb, nb, -1.0);
+}
+
+// C = C - A • transpose_of_B, computed as dot products of rows so that, like the transpose speedup, every access is
+// unit-stride - but without building the transpose
+void tile_multiply_transpose_subtract(const double* A, const double* B, double* C, int nb){
+    for (int i = 0; i < nb; i++) {
+        const double* A_row = A + (size_t)i * nb;
+        for (int j = 0; j < nb; j++) {
+            const double* B_row = B + (size_t)j * nb;
+            double temp = 0.0;
+            for (int k = 0; k < nb; k++)
+                temp += A_row[k] * B_row[k];
+            C[(size_t)i * nb + j] -= temp;
+        }
+    }
+}
+
+#endif //OPENMP_C_TUTORIAL_TILE_KERNELS_H
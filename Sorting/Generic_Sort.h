@@ -0,0 +1,345 @@
+#ifndef OPENMP_C_TUTORIAL_GENERIC_SORT_H
+#define OPENMP_C_TUTORIAL_GENERIC_SORT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <omp.h>
+#include "../Autotuning/Autotuner.h"
+#include "Sorting_Networks.h"
+
+/**
+ * Type-generic parallel Quicksort. The functions in Quicksort.h only sort int arrays with int bounds; the functions
+ * generated here use 64-bit indices and are instantiated for int32_t, int64_t, uint32_t, uint64_t, float and double:
+ *
+ *   parallel_sort_<type>(A, n, number_of_threads)
+ *       sorts A[0, n) in ascending order.
+ *   parallel_sort_pairs_<type>(keys, payload, payload_size, n, number_of_threads)
+ *       sorts keys[0, n) and applies the same permutation to payload[0, n), an array of n records of payload_size bytes
+ *       kept apart from the keys. Only the keys and an index array move during the sort; every record is moved once,
+ *       by a parallel gather at the end.
+ *
+ * Every instantiation is its own copy of the kernels, so comparisons are a single < on the key type and nothing goes
+ * through a comparison callback. Floating-point NaNs compare false against everything and would break the partition,
+ * so a first pass moves them to the end of the array and only the remaining prefix is sorted. The order of the NaNs
+ * among themselves is unspecified.
+ *
+ * Other key types can be added with GENERIC_SORT_DEFINE(name, type, is_nan, 0), where is_nan(x) is 0 for types
+ * without NaNs.
+ */
+
+#define GENERIC_SORT_SMALL 24               // subarrays up to this size are finished by insertion sort
+#define GENERIC_SORT_TASK_CUTOFF 1000       // default when the autotuner has no "quicksort_task_cutoff" entry
+
+#define GENERIC_SORT_NO_NAN(x) 0
+#define GENERIC_SORT_FLOAT_NAN(x) ((x) != (x))
+#define GENERIC_SORT_IS_FLOATING(TYPE) ((TYPE)0.5 != (TYPE)0)      // only floating-point keys can be NaN
+
+/// Gathers payload records in the order given by index, i.e. payload[i] = old payload[index[i]]. The payload has no
+/// alignment requirement: records are copied with memcpy(), which compiles to a single load and store for 4- and 8-byte
+/// records anyway. Both passes run on number_of_threads threads, like the sort itself.
+static void generic_sort_gather_payload(void* payload, size_t payload_size, const int64_t* index, int64_t n,
+                                        int number_of_threads){
+    char* scratch = (char*)malloc((size_t)n * payload_size);
+    char* source = (char*)payload;
+
+    #pragma omp parallel for num_threads(number_of_threads) default(none) \
+        shared(scratch, source, index, n, payload_size) schedule(static)
+    for (int64_t i = 0; i < n; i++)
+        memcpy(scratch + i * payload_size, source + index[i] * payload_size, payload_size);
+
+    #pragma omp parallel for num_threads(number_of_threads) default(none) \
+        shared(scratch, source, n, payload_size) schedule(static)
+    for (int64_t i = 0; i < n; i++)
+        memcpy(source + i * payload_size, scratch + i * payload_size, payload_size);
+
+    free(scratch);
+}
+
+/**
+ * Defines the sort kernels for one key type. index is either NULL or an array that receives every move of the keys.
+ * The swap loop of the partition, which does most of the moves, is written once for each case, so the keys-only sort
+ * never tests index there. A subarray still being partitioned after quicksort_depth_limit() levels is heapsorted.
+ */
+#define GENERIC_SORT_DEFINE(NAME, TYPE, IS_NAN, NETWORK)                                                                \
+                                                                                                                        \
+static void generic_sort_insertion_##NAME(TYPE* A, int64_t* index, int64_t lo, int64_t hi){                            \
+    for (int64_t i = lo + 1; i <= hi; i++) {                                                                           \
+        TYPE x = A[i];                                                                                                 \
+        int64_t x_index = index != NULL ? index[i] : 0;                                                                \
+        int64_t j = i - 1;                                                                                             \
+        while (j >= lo && x < A[j]) {                                                                                  \
+            A[j + 1] = A[j];                                                                                           \
+            if (index != NULL)                                                                                         \
+                index[j + 1] = index[j];                                                                               \
+            j--;                                                                                                       \
+        }                                                                                                              \
+        A[j + 1] = x;                                                                                                  \
+        if (index != NULL)                                                                                             \
+            index[j + 1] = x_index;                                                                                    \
+    }                                                                                                                  \
+}                                                                                                                      \
+                                                                                                                        \
+/* Index of the median of A[i], A[j] and A[k] */                                                                       \
+static inline int64_t generic_sort_median_##NAME(const TYPE* A, int64_t i, int64_t j, int64_t k){                      \
+    TYPE a = A[i], b = A[j], c = A[k];                                                                                 \
+    return a < b ? (b < c ? j : (a < c ? k : i)) : (a < c ? i : (b < c ? k : j));                                      \
+}                                                                                                                      \
+                                                                                                                       \
+static inline void generic_sort_swap_##NAME(TYPE* A, int64_t* index, int64_t i, int64_t j){                            \
+    TYPE t = A[i];                                                                                                     \
+    A[i] = A[j];                                                                                                       \
+    A[j] = t;                                                                                                          \
+    if (index != NULL) {                                                                                               \
+        int64_t t_index = index[i];                                                                                    \
+        index[i] = index[j];                                                                                           \
+        index[j] = t_index;                                                                                            \
+    }                                                                                                                  \
+}                                                                                                                      \
+                                                                                                                       \
+/* Heapsort of A[lo, hi], the fallback of the depth limit, as heap_sort() in Sorting_Networks.h */                     \
+static void generic_sort_sift_down_##NAME(TYPE* A, int64_t* index, int64_t root, int64_t n){                           \
+    for (int64_t child = 2 * root + 1; child < n; child = 2 * root + 1) {                                              \
+        if (child + 1 < n && A[child] < A[child + 1])                                                                  \
+            child++;                                                                                                   \
+        if (!(A[root] < A[child]))                                                                                     \
+            break;                                                                                                     \
+        generic_sort_swap_##NAME(A, index, root, child);                                                               \
+        root = child;                                                                                                  \
+    }                                                                                                                  \
+}                                                                                                                      \
+                                                                                                                       \
+static void generic_sort_heap_##NAME(TYPE* A, int64_t* index, int64_t lo, int64_t hi){                                 \
+    int64_t n = hi - lo + 1;                                                                                           \
+    TYPE* B = A + lo;                                                                                                  \
+    int64_t* B_index = index != NULL ? index + lo : NULL;                                                              \
+    for (int64_t i = n / 2 - 1; i >= 0; i--)                                                                           \
+        generic_sort_sift_down_##NAME(B, B_index, i, n);                                                               \
+    for (int64_t end = n - 1; end > 0; end--) {                                                                        \
+        generic_sort_swap_##NAME(B, B_index, 0, end);                                                                  \
+        generic_sort_sift_down_##NAME(B, B_index, 0, end);                                                             \
+    }                                                                                                                  \
+}                                                                                                                      \
+                                                                                                                       \
+/* Branchless two-sided block partition around the ninther, as branchless_partition() in Sorting_Networks.h */         \
+static void generic_sort_partition_##NAME(TYPE* A, int64_t* index, int64_t lo, int64_t hi,                             \
+                                          int64_t* left_end, int64_t* right_start){                                    \
+    int64_t mid = lo + (hi - lo) / 2;                                                                                  \
+    int64_t median;                                                                                                    \
+    if (hi - lo + 1 < QUICKSORT_NINTHER_MIN) {                                                                         \
+        median = generic_sort_median_##NAME(A, lo, mid, hi);                                                           \
+    } else {                                                                                                           \
+        int64_t step = (hi - lo + 1) / 8;                                                                              \
+        median = generic_sort_median_##NAME(A, generic_sort_median_##NAME(A, lo, lo + step, lo + 2 * step),            \
+                                            generic_sort_median_##NAME(A, mid - step, mid, mid + step),                \
+                                            generic_sort_median_##NAME(A, hi - 2 * step, hi - step, hi));              \
+    }                                                                                                                  \
+    generic_sort_swap_##NAME(A, index, lo, median);                                                                    \
+    TYPE pivot = A[lo];                                                                                                \
+                                                                                                                       \
+    unsigned char offsets_l[QUICKSORT_BLOCK], offsets_r[QUICKSORT_BLOCK];                                              \
+    int start_l = 0, start_r = 0, count_l = 0, count_r = 0;                                                            \
+    int64_t l = lo + 1, r = hi;                                                                                        \
+    while (r - l + 1 > 2 * QUICKSORT_BLOCK) {                                                                          \
+        if (count_l == 0) {                                                                                            \
+            start_l = 0;                                                                                               \
+            for (int i = 0; i < QUICKSORT_BLOCK; i++) {                                                                \
+                offsets_l[count_l] = (unsigned char)i;                                                                 \
+                count_l += !(A[l + i] < pivot);                                                                        \
+            }                                                                                                          \
+        }                                                                                                              \
+        if (count_r == 0) {                                                                                            \
+            start_r = 0;                                                                                               \
+            for (int i = 0; i < QUICKSORT_BLOCK; i++) {                                                                \
+                offsets_r[count_r] = (unsigned char)i;                                                                 \
+                count_r += !(pivot < A[r - i]);                                                                        \
+            }                                                                                                          \
+        }                                                                                                              \
+        int count = count_l < count_r ? count_l : count_r;                                                             \
+        if (index == NULL) {                                                                                           \
+            for (int i = 0; i < count; i++) {                                                                          \
+                TYPE* x = &A[l + offsets_l[start_l + i]];                                                              \
+                TYPE* y = &A[r - offsets_r[start_r + i]];                                                              \
+                TYPE t = *x;                                                                                           \
+                *x = *y;                                                                                               \
+                *y = t;                                                                                                \
+            }                                                                                                          \
+        } else {                                                                                                       \
+            for (int i = 0; i < count; i++)                                                                            \
+                generic_sort_swap_##NAME(A, index, l + offsets_l[start_l + i], r - offsets_r[start_r + i]);            \
+        }                                                                                                              \
+        count_l -= count;                                                                                              \
+        count_r -= count;                                                                                              \
+        start_l += count;                                                                                              \
+        start_r += count;                                                                                              \
+        l += count_l == 0 ? QUICKSORT_BLOCK : 0;                                                                       \
+        r -= count_r == 0 ? QUICKSORT_BLOCK : 0;                                                                       \
+    }                                                                                                                  \
+                                                                                                                       \
+    while (1) {                                                                                                        \
+        while (l <= r && A[l] < pivot)                                                                                 \
+            l++;                                                                                                       \
+        while (l <= r && pivot < A[r])                                                                                 \
+            r--;                                                                                                       \
+        if (l >= r)                                                                                                    \
+            break;                                                                                                     \
+        generic_sort_swap_##NAME(A, index, l++, r--);                                                                  \
+    }                                                                                                                  \
+    int64_t p = l == r ? l : r;                                                                                        \
+    generic_sort_swap_##NAME(A, index, lo, p);                                                                         \
+    *left_end = p - 1;                                                                                                 \
+    *right_start = p + 1;                                                                                              \
+}                                                                                                                      \
+                                                                                                                       \
+static void generic_sort_tasks_##NAME(TYPE* A, int64_t* index, int64_t lo, int64_t hi, int64_t cutoff, int depth){     \
+    if (NETWORK && index == NULL && hi - lo + 1 <= SORTING_NETWORK_MAX) {                                              \
+        sorting_network_sort((int*)(A + lo), (int)(hi - lo + 1));                                                      \
+        return;                                                                                                        \
+    }                                                                                                                  \
+    if (hi - lo + 1 <= GENERIC_SORT_SMALL) {                                                                           \
+        generic_sort_insertion_##NAME(A, index, lo, hi);                                                               \
+        return;                                                                                                        \
+    }                                                                                                                  \
+    if (depth == 0) {                                                                                                  \
+        generic_sort_heap_##NAME(A, index, lo, hi);                                                                    \
+        return;                                                                                                        \
+    }                                                                                                                  \
+    int64_t h, l;                                                                                                      \
+    generic_sort_partition_##NAME(A, index, lo, hi, &h, &l);                                                           \
+                                                                                                                       \
+    _Pragma("omp task final(h - lo < cutoff) default(none) shared(A, index) firstprivate(lo, h, cutoff, depth)")       \
+    generic_sort_tasks_##NAME(A, index, lo, h, cutoff, depth - 1);                                                     \
+                                                                                                                       \
+    _Pragma("omp task final(hi - l < cutoff) default(none) shared(A, index) firstprivate(l, hi, cutoff, depth)")       \
+    generic_sort_tasks_##NAME(A, index, l, hi, cutoff, depth - 1);                                                     \
+}                                                                                                                      \
+                                                                                                                        \
+/* Moves the NaNs to the end of A[0, n) and returns the number of other keys */                                        \
+static int64_t generic_sort_move_nans_##NAME(TYPE* A, int64_t* index, int64_t n){                                      \
+    int64_t s = 0;                                                                                                     \
+    for (int64_t i = 0; i < n; i++) {                                                                                  \
+        TYPE x = A[i];                                                                                                 \
+        int64_t keep = !(IS_NAN(x));                                                                                   \
+        A[i] = A[s];                                                                                                   \
+        A[s] = x;                                                                                                      \
+        if (index != NULL) {                                                                                           \
+            int64_t x_index = index[i];                                                                                \
+            index[i] = index[s];                                                                                       \
+            index[s] = x_index;                                                                                        \
+        }                                                                                                              \
+        s += keep;                                                                                                     \
+    }                                                                                                                  \
+    return s;                                                                                                          \
+}                                                                                                                      \
+                                                                                                                        \
+static void generic_sort_run_##NAME(TYPE* A, int64_t* index, int64_t n, int number_of_threads){                        \
+    if (n < 2)                                                                                                         \
+        return;                                                                                                        \
+    int64_t cutoff = (int64_t)autotune_get_clamped("quicksort_task_cutoff", n, GENERIC_SORT_TASK_CUTOFF, 1, n);        \
+    int64_t last = GENERIC_SORT_IS_FLOATING(TYPE) ? generic_sort_move_nans_##NAME(A, index, n) - 1 : n - 1;            \
+                                                                                                                        \
+    int depth = quicksort_depth_limit(last + 1);                                                                       \
+    _Pragma("omp parallel num_threads(number_of_threads) default(none) shared(A, index, last, cutoff, depth)")         \
+    {                                                                                                                  \
+        _Pragma("omp single")                                                                                          \
+        generic_sort_tasks_##NAME(A, index, 0, last, cutoff, depth);                                                   \
+    }                                                                                                                  \
+}                                                                                                                      \
+                                                                                                                        \
+void parallel_sort_##NAME(TYPE* A, int64_t n, int number_of_threads){                                                  \
+    generic_sort_run_##NAME(A, NULL, n, number_of_threads);                                                            \
+}                                                                                                                      \
+                                                                                                                        \
+void parallel_sort_pairs_##NAME(TYPE* keys, void* payload, size_t payload_size, int64_t n, int number_of_threads){     \
+    int64_t* index = (int64_t*)malloc((size_t)(n > 0 ? n : 1) * sizeof(int64_t));                                      \
+    _Pragma("omp parallel for num_threads(number_of_threads) default(none) shared(index, n) schedule(static)")         \
+    for (int64_t i = 0; i < n; i++)                                                                                    \
+        index[i] = i;                                                                                                  \
+                                                                                                                        \
+    generic_sort_run_##NAME(keys, index, n, number_of_threads);                                                        \
+    generic_sort_gather_payload(payload, payload_size, index, n, number_of_threads);                                   \
+    free(index);                                                                                                       \
+}
+
+// The keys-only int32 sort finishes small subarrays with the AVX2 sorting network of Sorting_Networks.h
+GENERIC_SORT_DEFINE(int32, int32_t, GENERIC_SORT_NO_NAN, 1)
+GENERIC_SORT_DEFINE(int64, int64_t, GENERIC_SORT_NO_NAN, 0)
+GENERIC_SORT_DEFINE(uint32, uint32_t, GENERIC_SORT_NO_NAN, 0)
+GENERIC_SORT_DEFINE(uint64, uint64_t, GENERIC_SORT_NO_NAN, 0)
+GENERIC_SORT_DEFINE(float, float, GENERIC_SORT_FLOAT_NAN, 0)
+GENERIC_SORT_DEFINE(double, double, GENERIC_SORT_FLOAT_NAN, 0)
+
+// Function to test the performance of the method
+// ----------------------------------------------
+/**
+ * Sorts n doubles with 1, 2, 4, ... up to max_threads threads, both alone and together with a 64-bit payload, and
+ * checks the results. The inputs are random (one in a thousand is a NaN), descending and organ pipe (ascending to the
+ * middle, then descending); the structured ones are those that turn a poor pivot choice quadratic.
+ */
+void sample_parallel_sort_double(int64_t n, int max_threads, int number_of_trials){
+    const char* names[] = {"random", "descending", "organ pipe"};
+    double* input = (double*)malloc((size_t)n * sizeof(double));
+    double* keys = (double*)malloc((size_t)n * sizeof(double));
+    uint64_t* payload = (uint64_t*)malloc((size_t)n * sizeof(uint64_t));
+    srand(1);
+
+    for (int pattern = 0; pattern < 3; pattern++) {
+        for (int64_t i = 0; i < n; i++) {
+            if (pattern == 0)
+                input[i] = rand() % 1000 == 0 ? NAN : (double)rand() / RAND_MAX - 0.5;
+            else if (pattern == 1)
+                input[i] = (double)(n - i);
+            else
+                input[i] = (double)(i < n / 2 ? i : n - i);
+        }
+
+        printf("Sorting %lld %s doubles with the generic parallel sort:\n", (long long)n, names[pattern]);
+        for (int threads = 1; ; threads *= 2) {
+            if (threads > max_threads)
+                threads = max_threads;
+
+            double keys_time = 0.0, pairs_time = 0.0;
+            int correct = 1;
+            for (int t = 0; t < number_of_trials; t++) {
+                memcpy(keys, input, (size_t)n * sizeof(double));
+                double start_time = omp_get_wtime();
+                parallel_sort_double(keys, n, threads);
+                keys_time += omp_get_wtime() - start_time;
+
+                memcpy(keys, input, (size_t)n * sizeof(double));
+                for (int64_t i = 0; i < n; i++)
+                    payload[i] = (uint64_t)i;
+                start_time = omp_get_wtime();
+                parallel_sort_pairs_double(keys, payload, sizeof(uint64_t), n, threads);
+                pairs_time += omp_get_wtime() - start_time;
+
+                // Sorted up to the NaNs, NaNs last, and every payload still names the position its key came from
+                int seen_nan = 0;
+                for (int64_t i = 0; i < n; i++) {
+                    if (isnan(keys[i]))
+                        seen_nan = 1;
+                    else if (seen_nan || (i > 0 && keys[i] < keys[i - 1]))
+                        correct = 0;
+                    if (memcmp(&keys[i], &input[payload[i]], sizeof(double)) != 0 && !isnan(keys[i]))
+                        correct = 0;
+                }
+            }
+
+            printf("%2d threads: keys %f seconds, keys and payload %f seconds%s\n", threads,
+                   keys_time / number_of_trials, pairs_time / number_of_trials, correct ? "" : " (WRONG RESULT)");
+            if (threads == max_threads)
+                break;
+        }
+        printf("\n");
+    }
+    printf("\n");
+
+    free(input);
+    free(keys);
+    free(payload);
+}
+
+#endif //OPENMP_C_TUTORIAL_GENERIC_SORT_H
@@ -4,8 +4,27 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <unistd.h>
 #include <omp.h>
+#include "../Autotuning/Autotuner.h"
+#include "Sorting_Networks.h"
+#include "../Tracing/Task_Trace.h"
+
+// Tuning parameters of the parallel Quicksort. They are loaded from the autotuner cache by the first call to
+// Parallel_Quicksort_1(); the initial values are used when the cache has no entry for them.
+// --------------------------------------------------------------------------------------------------------------------
+int QUICKSORT_TASK_CUTOFF = 1000;           // subarrays smaller than this are sorted inside one (final) task
+int QUICKSORT_NUMBER_OF_THREADS = 16;
+int QUICKSORT_TUNING_LOADED = 0;
+
+/// Loads the tuning parameters measured for arrays of about n elements
+void quicksort_load_tuning(long long n){
+    QUICKSORT_TASK_CUTOFF = (int)autotune_get_clamped("quicksort_task_cutoff", n, QUICKSORT_TASK_CUTOFF, 1, INT_MAX);
+    QUICKSORT_NUMBER_OF_THREADS = (int)autotune_get_clamped("quicksort_threads", n, QUICKSORT_NUMBER_OF_THREADS, 1,
+                                                            omp_get_thread_limit());
+    QUICKSORT_TUNING_LOADED = 1;
+}
 
 /// Sequential Quicksort
 void Quicksort(int* A, int lo, int hi){
@@ -43,37 +62,167 @@ void Quicksort(int* A, int lo, int hi){
     printf("The sequential Quicksort took %f seconds to complete.\n", end_time - start_time);
 }
 
-// Parallel Quicksort where each rec call is launched as a new task
-void Parallel_Quicksort_1(int* A, int lo, int hi){
-    omp_set_num_threads(16);
+// The recursion of Parallel_Quicksort_1(). depth counts down the partitioning levels left before the subarray is handed
+// to heap_sort(), which keeps inputs that defeat the pivot choice at O(n log n).
+void parallel_quicksort_tasks(int* A, int lo, int hi, int depth){
     if (lo > hi)
         return;
+    if (hi - lo + 1 <= SORTING_NETWORK_MAX) {
+        TRACE_TASK_BEGIN("sorting network");
+        sorting_network_sort(A + lo, hi - lo + 1);
+        TRACE_TASK_END("sorting network");
+        return;
+    }
+    if (depth == 0) {
+        TRACE_TASK_BEGIN("heap sort");
+        heap_sort(A + lo, hi - lo + 1);
+        TRACE_TASK_END("heap sort");
+        return;
+    }
     // Partition
     // --------------------------------
-    int l = lo;
-    int h = hi;
-    int pivot = A[(hi + lo) / 2];
+    TRACE_TASK_BEGIN("partition");
+    int h, l;
+    branchless_partition(A, lo, hi, &h, &l);
+    TRACE_TASK_END("partition");
+    // --------------------------------
+    #pragma omp task final(h - lo < QUICKSORT_TASK_CUTOFF) default(none) shared(A) firstprivate(lo, h, depth)
+    parallel_quicksort_tasks(A, lo, h, depth - 1);
 
-    while (l <= h){
-        while (A[l] < pivot && l < hi){
-            l++;
-        }
-        while (A[h] > pivot && h > lo){
-            h--;
+    #pragma omp task final(hi - l < QUICKSORT_TASK_CUTOFF) default(none) shared(A) firstprivate(l, hi, depth)
+    parallel_quicksort_tasks(A, l, hi, depth - 1);
+}
+
+// Parallel Quicksort where each rec call is launched as a new task. Subarrays of up to SORTING_NETWORK_MAX elements are
+// finished with a vectorized sorting network, and larger ones are split with a branchless partition around a ninther.
+// Call it from inside a parallel region (e.g. from a single construct); the team of that region runs the tasks.
+void Parallel_Quicksort_1(int* A, int lo, int hi){
+    if (!QUICKSORT_TUNING_LOADED)
+        quicksort_load_tuning(hi - lo + 1);
+    parallel_quicksort_tasks(A, lo, hi, quicksort_depth_limit(hi - lo + 1));
+}
+
+// Sorts A[0, n) with Parallel_Quicksort_1() in a parallel region of its own, whose team has the tuned number of threads
+void parallel_quicksort(int* A, int n){
+    if (!QUICKSORT_TUNING_LOADED)
+        quicksort_load_tuning(n);
+
+    #pragma omp parallel num_threads(QUICKSORT_NUMBER_OF_THREADS) default(none) shared(A, n)
+    {
+        TRACE_REGION_BEGIN("parallel quicksort");
+        #pragma omp single
+        Parallel_Quicksort_1(A, 0, n - 1);
+        TRACE_REGION_END("parallel quicksort");
+    }
+}
+
+// Autotuning
+// ----------
+typedef struct {
+    const int* input;       // the unsorted array every trial starts from
+    int* work;
+    int threads;
+} quicksort_tuning_context;
+
+double measure_parallel_quicksort(long long cutoff, long long n, void* context){
+    quicksort_tuning_context* c = (quicksort_tuning_context*)context;
+    for (long long i = 0; i < n; i++)
+        c->work[i] = c->input[i];
+
+    QUICKSORT_TASK_CUTOFF = (int)cutoff;
+    QUICKSORT_NUMBER_OF_THREADS = c->threads;
+
+    double start_time = omp_get_wtime();
+    parallel_quicksort(c->work, (int)n);
+    return omp_get_wtime() - start_time;
+}
+
+double measure_parallel_quicksort_threads(long long threads, long long n, void* context){
+    quicksort_tuning_context* c = (quicksort_tuning_context*)context;
+    c->threads = (int)threads;
+    return measure_parallel_quicksort(QUICKSORT_TASK_CUTOFF, n, context);
+}
+
+/**
+ * Searches the task cutoff and the number of threads of Parallel_Quicksort_1() for arrays of n random integers, then
+ * saves the results to the autotuner cache. The thread count is tuned first with the current cutoff, and the cutoff is
+ * then tuned with the best thread count.
+ */
+void autotune_parallel_quicksort(int n, int number_of_trials){
+    int* input = (int*)malloc(n * sizeof(int));
+    int* work = (int*)malloc(n * sizeof(int));
+    srand(1);
+    for (int i = 0; i < n; i++)
+        input[i] = rand();
+
+    quicksort_tuning_context context = {input, work, QUICKSORT_NUMBER_OF_THREADS};
+    QUICKSORT_TUNING_LOADED = 1;        // keep the lazy load from overwriting the candidates
+
+    long long threads[AUTOTUNE_MAX_CANDIDATES];
+    int number_of_thread_candidates = autotune_thread_candidates(threads);
+    printf("Tuning the number of threads of the parallel Quicksort (n = %d):\n", n);
+    context.threads = (int)autotune_search("quicksort_threads", n, threads, number_of_thread_candidates,
+                                           measure_parallel_quicksort_threads, &context, number_of_trials);
+
+    long long cutoffs[] = {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000};
+    printf("Tuning the task cutoff of the parallel Quicksort (n = %d):\n", n);
+    autotune_search("quicksort_task_cutoff", n, cutoffs, sizeof(cutoffs) / sizeof(cutoffs[0]),
+                    measure_parallel_quicksort, &context, number_of_trials);
+
+    autotune_save();
+    quicksort_load_tuning(n);
+
+    free(input);
+    free(work);
+}
+
+// Function to test the performance of the method
+// ----------------------------------------------
+/**
+ * Fills A[0, n) with one of the inputs of sample_parallel_quicksort(): 0 random, 1 ascending, 2 descending, 3 organ
+ * pipe (ascending to the middle, then descending) and 4 all keys equal.
+ */
+void quicksort_fill_input(int* A, int n, int pattern){
+    for (int i = 0; i < n; i++) {
+        switch (pattern) {
+            case 0: A[i] = rand(); break;
+            case 1: A[i] = i; break;
+            case 2: A[i] = n - i; break;
+            case 3: A[i] = i < n / 2 ? i : n - i; break;
+            default: A[i] = 42;
         }
-        if (l <= h){
-            int temp = A[l];
-            A[l] = A[h];
-            A[h] = temp;
-            l++;
-            h--;
+    }
+}
+
+/**
+ * Sorts n ints with Parallel_Quicksort_1() for each input of quicksort_fill_input() and checks the results. The
+ * structured inputs are the ones that turn a poor pivot choice quadratic.
+ */
+void sample_parallel_quicksort(int n, int number_of_trials){
+    const char* names[] = {"random", "ascending", "descending", "organ pipe", "all equal"};
+    int* A = (int*)malloc(n * sizeof(int));
+    srand(1);
+
+    if (!QUICKSORT_TUNING_LOADED)
+        quicksort_load_tuning(n);
+    printf("Sorting %d ints with the parallel Quicksort (%d threads):\n", n, QUICKSORT_NUMBER_OF_THREADS);
+    for (int pattern = 0; pattern < 5; pattern++) {
+        double total_time = 0.0;
+        int correct = 1;
+        for (int t = 0; t < number_of_trials; t++) {
+            quicksort_fill_input(A, n, pattern);
+            double start_time = omp_get_wtime();
+            parallel_quicksort(A, n);
+            total_time += omp_get_wtime() - start_time;
+
+            for (int i = 1; i < n; i++)
+                if (A[i] < A[i - 1])
+                    correct = 0;
         }
+        printf("%-10s input: %f seconds%s\n", names[pattern], total_time / number_of_trials,
+               correct ? "" : " (WRONG RESULT)");
     }
-    // --------------------------------
-    #pragma omp task final(h - lo < 1000) default(none) shared(A, lo, h)
-    Parallel_Quicksort_1(A, lo, h);
+    printf("\n\n");
 
-    #pragma omp task final(hi - l < 1000) default(none) shared(A, l, hi)
-    Parallel_Quicksort_1(A, l, hi);
+    free(A);
 }
-
@@ -0,0 +1,260 @@
+#ifndef OPENMP_C_TUTORIAL_SORTING_NETWORKS_H
+#define OPENMP_C_TUTORIAL_SORTING_NETWORKS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/**
+ * Building blocks that keep the bottom of the Quicksort recursion free of unpredictable branches:
+ *  - sorting_network_sort() sorts up to SORTING_NETWORK_MAX ints with a bitonic sorting network that runs entirely in
+ *    AVX2 registers (8 ints each): every register is sorted in place, then sorted runs of registers are merged with
+ *    in-register bitonic merges. The comparisons are vector min/max operations, so there is nothing to mispredict.
+ *  - branchless_partition() is a two-sided block partition: the elements on the wrong side are found by branchless
+ *    scans of small blocks at both ends, and only then swapped.
+ *  - heap_sort() and quicksort_depth_limit() bound the recursion: a Quicksort that is still partitioning after
+ *    quicksort_depth_limit(n) levels finishes the subarray with heap_sort(), so no input makes it quadratic.
+ *
+ * Without AVX2 (compile with -mavx2 or -march=native to enable it), sorting_network_sort() falls back to insertion sort.
+ */
+
+#define SORTING_NETWORK_MAX 256             // 32 AVX2 registers of 8 ints
+#define QUICKSORT_NINTHER_MIN 128           // partitions of at least this many elements use the ninther as pivot
+#define QUICKSORT_BLOCK 64                  // elements scanned at each end per step of branchless_partition()
+
+#ifdef __AVX2__
+
+// Lane masks for _mm256_blend_epi32(lo, hi, mask): a set bit means that lane takes the maximum of the pair
+#define SN_STAGE(v, shuffled, mask) _mm256_blend_epi32(_mm256_min_epi32(v, shuffled), _mm256_max_epi32(v, shuffled), mask)
+#define SN_SWAP_PAIRS(v) _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1))          // lane i <-> i ^ 1
+#define SN_SWAP_QUADS(v) _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2))          // lane i <-> i ^ 2
+#define SN_SWAP_HALVES(v) _mm256_permute2x128_si256(v, v, 1)                       // lane i <-> i ^ 4
+
+/// Sorts a register that holds a bitonic sequence into ascending order
+static inline __m256i sorting_network_merge_register(__m256i v){
+    v = SN_STAGE(v, SN_SWAP_HALVES(v), 0xF0);
+    v = SN_STAGE(v, SN_SWAP_QUADS(v), 0xCC);
+    v = SN_STAGE(v, SN_SWAP_PAIRS(v), 0xAA);
+    return v;
+}
+
+/// Sorts the 8 lanes of a register into ascending order
+static inline __m256i sorting_network_sort_register(__m256i v){
+    v = SN_STAGE(v, SN_SWAP_PAIRS(v), 0x66);          // pairs alternately ascending and descending
+    v = SN_STAGE(v, SN_SWAP_QUADS(v), 0x3C);          // quads alternately ascending and descending
+    v = SN_STAGE(v, SN_SWAP_PAIRS(v), 0x5A);
+    return sorting_network_merge_register(v);
+}
+
+static inline __m256i sorting_network_reverse_register(__m256i v){
+    return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+/**
+ * Merges the two ascending runs r[0, run) and r[run, 2 * run) into one ascending run. Reversing the second run makes
+ * the pair a bitonic sequence; half-cleaners between registers then leave every register bitonic, and each register is
+ * finished in place.
+ */
+static inline void sorting_network_merge_runs(__m256i* r, int run){
+    for (int i = 0; i < run / 2; i++) {
+        __m256i t = r[run + i];
+        r[run + i] = r[2 * run - 1 - i];
+        r[2 * run - 1 - i] = t;
+    }
+    for (int i = run; i < 2 * run; i++)
+        r[i] = sorting_network_reverse_register(r[i]);
+
+    for (int distance = run; distance >= 1; distance /= 2) {
+        for (int i = 0; i < 2 * run; i++) {
+            if (i & distance)
+                continue;
+            __m256i lo = _mm256_min_epi32(r[i], r[i + distance]);
+            __m256i hi = _mm256_max_epi32(r[i], r[i + distance]);
+            r[i] = lo;
+            r[i + distance] = hi;
+        }
+    }
+    for (int i = 0; i < 2 * run; i++)
+        r[i] = sorting_network_merge_register(r[i]);
+}
+
+#endif
+
+/**
+ * Sorts A[0, n) for n <= SORTING_NETWORK_MAX. The input is padded with INT_MAX up to a power of two number of registers,
+ * so the network always has the same shape for a given register count.
+ */
+void sorting_network_sort(int* A, int n){
+#ifdef __AVX2__
+    __m256i r[SORTING_NETWORK_MAX / 8];
+    int registers = 1;
+    while (registers * 8 < n)
+        registers *= 2;
+
+    _Alignas(32) int padded[SORTING_NETWORK_MAX];
+    for (int i = 0; i < n; i++)
+        padded[i] = A[i];
+    for (int i = n; i < registers * 8; i++)
+        padded[i] = INT_MAX;
+
+    for (int i = 0; i < registers; i++)
+        r[i] = sorting_network_sort_register(_mm256_load_si256((const __m256i*)(padded + 8 * i)));
+    for (int run = 1; run < registers; run *= 2)
+        for (int i = 0; i < registers; i += 2 * run)
+            sorting_network_merge_runs(r + i, run);
+
+    for (int i = 0; i < registers; i++)
+        _mm256_store_si256((__m256i*)(padded + 8 * i), r[i]);
+    for (int i = 0; i < n; i++)
+        A[i] = padded[i];
+#else
+    for (int i = 1; i < n; i++) {
+        int x = A[i];
+        int j = i - 1;
+        while (j >= 0 && A[j] > x) {
+            A[j + 1] = A[j];
+            j--;
+        }
+        A[j + 1] = x;
+    }
+#endif
+}
+
+/// Index of the median of A[i], A[j] and A[k]
+static inline int median_of_three(const int* A, int i, int j, int k){
+    int a = A[i], b = A[j], c = A[k];
+    return a < b ? (b < c ? j : (a < c ? k : i)) : (a < c ? i : (b < c ? k : j));
+}
+
+/**
+ * Picks the pivot of A[lo, hi]: the median of three for short subarrays, and Tukey's ninther (the median of the medians
+ * of three evenly spaced triples) for longer ones, which is much harder to push towards an extreme with structured
+ * inputs such as organ-pipe arrays.
+ */
+static inline int quicksort_pivot(const int* A, int lo, int hi){
+    int n = hi - lo + 1;
+    int mid = lo + (hi - lo) / 2;
+    if (n < QUICKSORT_NINTHER_MIN)
+        return median_of_three(A, lo, mid, hi);
+    int step = n / 8;
+    return median_of_three(A, median_of_three(A, lo, lo + step, lo + 2 * step),
+                           median_of_three(A, mid - step, mid, mid + step),
+                           median_of_three(A, hi - 2 * step, hi - step, hi));
+}
+
+/// Moves A[root] down the max-heap A[0, n) until both of its children are not larger
+static inline void heap_sift_down(int* A, int root, int n){
+    int x = A[root];
+    for (int child = 2 * root + 1; child < n; child = 2 * root + 1) {
+        if (child + 1 < n && A[child] < A[child + 1])
+            child++;
+        if (!(x < A[child]))
+            break;
+        A[root] = A[child];
+        root = child;
+    }
+    A[root] = x;
+}
+
+/// Heapsort of A[0, n): the fallback that bounds Quicksort at O(n log n) when the pivots keep coming out unbalanced
+void heap_sort(int* A, int n){
+    for (int i = n / 2 - 1; i >= 0; i--)
+        heap_sift_down(A, i, n);
+    for (int end = n - 1; end > 0; end--) {
+        int t = A[0];
+        A[0] = A[end];
+        A[end] = t;
+        heap_sift_down(A, 0, end);
+    }
+}
+
+/// Number of partitioning levels after which Quicksort switches to heap_sort(): twice the depth of a balanced split
+static inline int quicksort_depth_limit(long long n){
+    int depth = 0;
+    while (n > 1) {
+        n >>= 1;
+        depth += 2;
+    }
+    return depth;
+}
+
+/**
+ * Partitions A[lo, hi] around the pivot chosen by quicksort_pivot(). On return A[lo, *left_end] holds elements not
+ * larger than the pivot, A[*right_start, hi] elements not smaller than it, and the pivot itself sits in between.
+ *
+ * This is a two-sided (Hoare) partition made branchless in the way of BlockQuicksort (Edelkamp and Weiss): a block of
+ * QUICKSORT_BLOCK elements is scanned from each end, and the offsets of the elements that are on the wrong side are
+ * recorded without branching (the slot is always written, the count advances by the result of the comparison). The
+ * recorded elements are then swapped in pairs. Elements equal to the pivot stop both scans, as in Hoare's scheme, so
+ * runs of equal keys are split evenly instead of all landing on one side. The last 2 * QUICKSORT_BLOCK elements or
+ * fewer are finished by the classic scalar loop.
+ */
+void branchless_partition(int* A, int lo, int hi, int* left_end, int* right_start){
+    int median = quicksort_pivot(A, lo, hi);
+    int pivot = A[median];
+    A[median] = A[lo];
+    A[lo] = pivot;
+
+    // Invariant: A[lo + 1, l) <= pivot and A(r, hi] >= pivot
+    unsigned char offsets_l[QUICKSORT_BLOCK], offsets_r[QUICKSORT_BLOCK];
+    int start_l = 0, start_r = 0, count_l = 0, count_r = 0;
+    int l = lo + 1, r = hi;
+    while (r - l + 1 > 2 * QUICKSORT_BLOCK) {
+        if (count_l == 0) {
+            start_l = 0;
+            for (int i = 0; i < QUICKSORT_BLOCK; i++) {
+                offsets_l[count_l] = (unsigned char)i;
+                count_l += !(A[l + i] < pivot);
+            }
+        }
+        if (count_r == 0) {
+            start_r = 0;
+            for (int i = 0; i < QUICKSORT_BLOCK; i++) {
+                offsets_r[count_r] = (unsigned char)i;
+                count_r += !(pivot < A[r - i]);
+            }
+        }
+        int count = count_l < count_r ? count_l : count_r;
+        for (int i = 0; i < count; i++) {
+            int* x = &A[l + offsets_l[start_l + i]];
+            int* y = &A[r - offsets_r[start_r + i]];
+            int t = *x;
+            *x = *y;
+            *y = t;
+        }
+        count_l -= count;
+        count_r -= count;
+        start_l += count;
+        start_r += count;
+        l += count_l == 0 ? QUICKSORT_BLOCK : 0;
+        r -= count_r == 0 ? QUICKSORT_BLOCK : 0;
+    }
+
+    // The unfinished blocks are still inside [l, r], so rescanning them is safe
+    while (1) {
+        while (l <= r && A[l] < pivot)
+            l++;
+        while (l <= r && pivot < A[r])
+            r--;
+        if (l >= r)
+            break;
+        int t = A[l];
+        A[l] = A[r];
+        A[r] = t;
+        l++;
+        r--;
+    }
+    int p = l == r ? l : r;             // last position of the left side; l == r only stops on a copy of the pivot
+
+    A[lo] = A[p];
+    A[p] = pivot;
+    *left_end = p - 1;
+    *right_start = p + 1;
+}
+
+#endif //OPENMP_C_TUTORIAL_SORTING_NETWORKS_H
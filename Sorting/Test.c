@@ -0,0 +1,11 @@
+#include "Quicksort.h"
+#include "Generic_Sort.h"
+
+int main() {
+
+    sample_parallel_quicksort(2000000, 3);
+
+    sample_parallel_sort_double(2000000, 4, 3);
+
+    return 0;
+}
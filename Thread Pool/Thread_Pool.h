@@ -0,0 +1,256 @@
+#ifndef OPENMP_C_TUTORIAL_THREAD_POOL_H
+#define OPENMP_C_TUTORIAL_THREAD_POOL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <omp.h>
+
+/**
+ * A persistent pool of worker threads with a submit/future interface. Every kernel in this repository opens a new
+ * OpenMP parallel region (and often changes the global thread count) on each call; when the inputs are small and the
+ * calls are frequent, forking and joining the team costs more than the work itself. The pool starts its workers once,
+ * and many independent kernel invocations can be queued, run concurrently and awaited.
+ *
+ * Work is queued in a bounded lock-free multi-producer/multi-consumer ring (D. Vyukov's sequence-number queue). Idle
+ * workers spin on the queue for THREAD_POOL_SPIN iterations before they park on a condition variable, so a submission
+ * that arrives shortly after the previous one is picked up within microseconds without burning a core forever.
+ *
+ * Futures are owned by the caller, typically on its stack or inside the argument struct of the task, so submitting
+ * does not allocate. A future must stay alive until thread_pool_wait() has returned for it.
+ */
+
+#define THREAD_POOL_QUEUE_CAPACITY 4096        // must be a power of two
+#define THREAD_POOL_SPIN 20000                  // queue polls before an idle worker parks
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define THREAD_POOL_PAUSE() _mm_pause()
+#else
+#define THREAD_POOL_PAUSE() ((void)0)
+#endif
+
+// Runtime of the last pool-based sample, shared by every module that drives its kernels through the pool:
+// ------------------------------------------------------------------------------------------------------
+double THREAD_POOL_RUNTIME[1];
+
+typedef struct {
+    void (*function)(void*);
+    void* argument;
+    atomic_int done;
+} thread_pool_future;
+
+typedef struct {
+    atomic_size_t sequence;
+    thread_pool_future* future;
+} thread_pool_slot;
+
+typedef struct {
+    thread_pool_slot slots[THREAD_POOL_QUEUE_CAPACITY];
+
+    // Producer and consumer positions on separate cache lines so that submitting and dequeuing do not false share
+    _Alignas(64) atomic_size_t enqueue_position;
+    _Alignas(64) atomic_size_t dequeue_position;
+
+    _Alignas(64) atomic_int sleeping;
+    atomic_int stop;
+    pthread_mutex_t lock;
+    pthread_cond_t work_available;
+
+    pthread_t* workers;
+    int number_of_workers;
+} thread_pool;
+
+static int thread_pool_try_enqueue(thread_pool* pool, thread_pool_future* future){
+    size_t position = atomic_load_explicit(&pool->enqueue_position, memory_order_relaxed);
+    for (;;) {
+        thread_pool_slot* slot = &pool->slots[position & (THREAD_POOL_QUEUE_CAPACITY - 1)];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        long difference = (long)sequence - (long)position;
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&pool->enqueue_position, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                slot->future = future;
+                atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+                return 1;
+            }
+        } else if (difference < 0) {
+            return 0;               // full
+        } else {
+            position = atomic_load_explicit(&pool->enqueue_position, memory_order_relaxed);
+        }
+    }
+}
+
+static thread_pool_future* thread_pool_try_dequeue(thread_pool* pool){
+    size_t position = atomic_load_explicit(&pool->dequeue_position, memory_order_relaxed);
+    for (;;) {
+        thread_pool_slot* slot = &pool->slots[position & (THREAD_POOL_QUEUE_CAPACITY - 1)];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        long difference = (long)sequence - (long)(position + 1);
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&pool->dequeue_position, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                thread_pool_future* future = slot->future;
+                atomic_store_explicit(&slot->sequence, position + THREAD_POOL_QUEUE_CAPACITY, memory_order_release);
+                return future;
+            }
+        } else if (difference < 0) {
+            return NULL;            // empty
+        } else {
+            position = atomic_load_explicit(&pool->dequeue_position, memory_order_relaxed);
+        }
+    }
+}
+
+static void thread_pool_run(thread_pool_future* future){
+    future->function(future->argument);
+    atomic_store_explicit(&future->done, 1, memory_order_release);
+}
+
+static void* thread_pool_worker(void* argument){
+    thread_pool* pool = (thread_pool*)argument;
+
+    while (!atomic_load_explicit(&pool->stop, memory_order_acquire)) {
+        thread_pool_future* future = NULL;
+
+        // Spin...
+        for (int spin = 0; spin < THREAD_POOL_SPIN && future == NULL; spin++) {
+            future = thread_pool_try_dequeue(pool);
+            if (future == NULL)
+                THREAD_POOL_PAUSE();
+        }
+
+        // ...then park. The queue is checked again after announcing that this worker sleeps, and submitters check
+        // the number of sleepers after enqueuing. The two seq_cst fences (here and in thread_pool_submit) order each
+        // side's store before its load, so at least one of them sees the other and a wake-up cannot be lost.
+        if (future == NULL) {
+            pthread_mutex_lock(&pool->lock);
+            atomic_fetch_add(&pool->sleeping, 1);
+            atomic_thread_fence(memory_order_seq_cst);
+            while ((future = thread_pool_try_dequeue(pool)) == NULL && !atomic_load(&pool->stop))
+                pthread_cond_wait(&pool->work_available, &pool->lock);
+            atomic_fetch_sub(&pool->sleeping, 1);
+            pthread_mutex_unlock(&pool->lock);
+        }
+
+        if (future != NULL)
+            thread_pool_run(future);
+    }
+    return NULL;
+}
+
+/// Wakes every worker with the stop flag set and joins the ones that were started
+static void thread_pool_stop_workers(thread_pool* pool){
+    pthread_mutex_lock(&pool->lock);
+    atomic_store(&pool->stop, 1);
+    pthread_cond_broadcast(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->number_of_workers; i++)
+        pthread_join(pool->workers[i], NULL);
+    free(pool->workers);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_available);
+}
+
+/**
+ * Starts a pool of number_of_workers threads.
+ * @return 0 on success, -1 if the workers could not be created. On failure the workers that were already started are
+ * stopped and joined, and the pool must not be used or destroyed.
+ */
+int thread_pool_init(thread_pool* pool, int number_of_workers){
+    for (size_t i = 0; i < THREAD_POOL_QUEUE_CAPACITY; i++)
+        atomic_init(&pool->slots[i].sequence, i);
+    atomic_init(&pool->enqueue_position, 0);
+    atomic_init(&pool->dequeue_position, 0);
+    atomic_init(&pool->sleeping, 0);
+    atomic_init(&pool->stop, 0);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_available, NULL);
+
+    pool->workers = (pthread_t*)malloc(number_of_workers * sizeof(pthread_t));
+    pool->number_of_workers = 0;
+    if (pool->workers == NULL) {
+        pthread_mutex_destroy(&pool->lock);
+        pthread_cond_destroy(&pool->work_available);
+        return -1;
+    }
+
+    for (int i = 0; i < number_of_workers; i++) {
+        if (pthread_create(&pool->workers[i], NULL, thread_pool_worker, pool) != 0) {
+            thread_pool_stop_workers(pool);
+            return -1;
+        }
+        pool->number_of_workers++;
+    }
+    return 0;
+}
+
+/**
+ * Queues function(argument) for execution by a worker. The future is reset and completed by the pool. When the queue is
+ * full the task runs on the calling thread, which keeps the queue bounded without ever blocking a submitter.
+ */
+void thread_pool_submit(thread_pool* pool, thread_pool_future* future, void (*function)(void*), void* argument){
+    future->function = function;
+    future->argument = argument;
+    atomic_store_explicit(&future->done, 0, memory_order_relaxed);
+
+    if (!thread_pool_try_enqueue(pool, future)) {
+        thread_pool_run(future);
+        return;
+    }
+
+    // Pairs with the fence in thread_pool_worker: the enqueue is ordered before the load of the number of sleepers
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&pool->sleeping) > 0) {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_signal(&pool->work_available);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/**
+ * Returns non-zero once the task of the future has finished.
+ */
+int thread_pool_ready(thread_pool_future* future){
+    return atomic_load_explicit(&future->done, memory_order_acquire);
+}
+
+/**
+ * Waits until the task of the future has finished. While waiting, the calling thread runs other queued tasks, so it
+ * is safe to wait from inside a task and a caller that submits a batch and waits for it contributes to the batch.
+ */
+void thread_pool_wait(thread_pool* pool, thread_pool_future* future){
+    while (!thread_pool_ready(future)) {
+        thread_pool_future* other = thread_pool_try_dequeue(pool);
+        if (other != NULL)
+            thread_pool_run(other);
+        else
+            THREAD_POOL_PAUSE();
+    }
+}
+
+/**
+ * Waits for every future in the array.
+ */
+void thread_pool_wait_all(thread_pool* pool, thread_pool_future* futures, int count){
+    for (int i = 0; i < count; i++)
+        thread_pool_wait(pool, &futures[i]);
+}
+
+/**
+ * Stops the workers once the tasks already queued have been run, and joins them.
+ */
+void thread_pool_destroy(thread_pool* pool){
+    thread_pool_future* future;
+    while ((future = thread_pool_try_dequeue(pool)) != NULL)
+        thread_pool_run(future);
+
+    thread_pool_stop_workers(pool);
+}
+
+#endif //OPENMP_C_TUTORIAL_THREAD_POOL_H
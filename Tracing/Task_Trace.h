@@ -0,0 +1,214 @@
+#ifndef OPENMP_C_TUTORIAL_TASK_TRACE_H
+#define OPENMP_C_TUTORIAL_TASK_TRACE_H
+
+/**
+ * A per-thread timeline tracer for the parallel kernels. Instrumented code marks where parallel regions, tasks and
+ * barriers begin and end; every thread appends these events to its own ring buffer, so recording takes no lock and
+ * touches no shared cache line. TRACE_EXPORT() writes the timelines as Chrome trace JSON, which can be opened in
+ * chrome://tracing or https://ui.perfetto.dev. Gaps between a thread's tasks inside a parallel region are exported as
+ * "idle" slices, which makes load imbalance and scheduling overhead visible at a glance.
+ *
+ * Tracing is enabled by compiling with -DPARALLEL_TRACE. Without it every TRACE_* macro expands to nothing and none of
+ * the code below is compiled.
+ *
+ * A ring buffer holds the last TRACE_BUFFER_EVENTS events of its thread. When a thread records more than that, its
+ * oldest events are overwritten, and the exporter skips end events whose begin event was lost.
+ */
+
+#ifdef PARALLEL_TRACE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <omp.h>
+
+#define TRACE_BUFFER_EVENTS (1 << 16)           // per thread, must be a power of two
+#define TRACE_MAX_THREADS 256
+
+typedef enum {
+    TRACE_REGION_ENTER,
+    TRACE_REGION_EXIT,
+    TRACE_SLICE_BEGIN,          // a task or any other named piece of work
+    TRACE_SLICE_END,
+    TRACE_BARRIER_ENTER,
+    TRACE_BARRIER_EXIT
+} trace_event_kind;
+
+typedef struct {
+    unsigned long long timestamp;               // nanoseconds, CLOCK_MONOTONIC
+    const char* name;                           // must be a string literal or otherwise outlive the export
+    trace_event_kind kind;
+} trace_event;
+
+typedef struct {
+    trace_event events[TRACE_BUFFER_EVENTS];
+    atomic_ullong head;                         // number of events ever recorded
+    int thread;
+} trace_buffer;
+
+trace_buffer* TRACE_BUFFERS[TRACE_MAX_THREADS];
+atomic_int TRACE_NUMBER_OF_BUFFERS = 0;
+static _Thread_local trace_buffer* TRACE_THREAD_BUFFER = NULL;
+
+static inline unsigned long long trace_now(void){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (unsigned long long)t.tv_sec * 1000000000ULL + (unsigned long long)t.tv_nsec;
+}
+
+/// Registers a buffer for the calling thread on its first event
+static trace_buffer* trace_thread_buffer(void){
+    if (TRACE_THREAD_BUFFER == NULL) {
+        int slot = atomic_fetch_add(&TRACE_NUMBER_OF_BUFFERS, 1);
+        if (slot >= TRACE_MAX_THREADS)
+            return NULL;
+        trace_buffer* buffer = (trace_buffer*)calloc(1, sizeof(trace_buffer));
+        if (buffer == NULL)
+            return NULL;
+        buffer->thread = slot;
+        TRACE_BUFFERS[slot] = buffer;
+        TRACE_THREAD_BUFFER = buffer;
+    }
+    return TRACE_THREAD_BUFFER;
+}
+
+static inline void trace_record(trace_event_kind kind, const char* name){
+    trace_buffer* buffer = trace_thread_buffer();
+    if (buffer == NULL)
+        return;
+
+    // Only the owning thread writes, so a relaxed read of head is enough; the release store publishes the event
+    unsigned long long head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    trace_event* e = &buffer->events[head & (TRACE_BUFFER_EVENTS - 1)];
+    e->timestamp = trace_now();
+    e->name = name;
+    e->kind = kind;
+    atomic_store_explicit(&buffer->head, head + 1, memory_order_release);
+}
+
+static void trace_write_event(FILE* f, int* first, const char* name, const char* phase, int thread,
+                              unsigned long long timestamp, unsigned long long origin, const char* extra){
+    fprintf(f, "%s\n{\"name\":\"%s\",\"ph\":\"%s\",\"pid\":0,\"tid\":%d,\"ts\":%.3f%s}", *first ? "" : ",",
+            name, phase, thread, (timestamp - origin) / 1000.0, extra);
+    *first = 0;
+}
+
+/**
+ * Writes the events recorded so far as a Chrome trace. Call it when no thread is recording, e.g. after the parallel
+ * region of interest has ended.
+ * @return 0 on success, -1 if the file could not be written.
+ */
+int trace_export(const char* path){
+    FILE* f = fopen(path, "w");
+    if (f == NULL)
+        return -1;
+
+    int buffers = atomic_load(&TRACE_NUMBER_OF_BUFFERS);
+    if (buffers > TRACE_MAX_THREADS)
+        buffers = TRACE_MAX_THREADS;
+
+    // Timestamps are exported relative to the earliest event still held in any buffer
+    unsigned long long origin = ~0ULL;
+    for (int b = 0; b < buffers; b++) {
+        trace_buffer* buffer = TRACE_BUFFERS[b];
+        unsigned long long head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+        unsigned long long tail = head > TRACE_BUFFER_EVENTS ? head - TRACE_BUFFER_EVENTS : 0;
+        if (head > tail && buffer->events[tail & (TRACE_BUFFER_EVENTS - 1)].timestamp < origin)
+            origin = buffer->events[tail & (TRACE_BUFFER_EVENTS - 1)].timestamp;
+    }
+
+    int first = 1;
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (int b = 0; b < buffers; b++) {
+        trace_buffer* buffer = TRACE_BUFFERS[b];
+        unsigned long long head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+        unsigned long long tail = head > TRACE_BUFFER_EVENTS ? head - TRACE_BUFFER_EVENTS : 0;
+
+        int depth = 0;                          // open slices and barriers
+        int regions = 0;                        // open parallel regions
+        unsigned long long idle_since = 0;
+
+        fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                first ? "" : ",", buffer->thread, buffer->thread);
+        first = 0;
+
+        for (unsigned long long i = tail; i < head; i++) {
+            trace_event* e = &buffer->events[i & (TRACE_BUFFER_EVENTS - 1)];
+            int opens = e->kind == TRACE_REGION_ENTER || e->kind == TRACE_SLICE_BEGIN || e->kind == TRACE_BARRIER_ENTER;
+
+            // A thread inside a parallel region but outside any slice or barrier is idle. Idle time right before the
+            // region exits is the wait at the region's implicit barrier.
+            if ((opens || e->kind == TRACE_REGION_EXIT) && regions > 0 && depth == 0 && e->timestamp > idle_since) {
+                char extra[64];
+                snprintf(extra, sizeof(extra), ",\"dur\":%.3f", (e->timestamp - idle_since) / 1000.0);
+                trace_write_event(f, &first, "idle", "X", buffer->thread, idle_since, origin, extra);
+            }
+
+            switch (e->kind) {
+                case TRACE_REGION_ENTER:
+                    trace_write_event(f, &first, e->name, "B", buffer->thread, e->timestamp, origin, "");
+                    regions++;
+                    break;
+                case TRACE_SLICE_BEGIN:
+                case TRACE_BARRIER_ENTER:
+                    trace_write_event(f, &first, e->kind == TRACE_BARRIER_ENTER ? "barrier" : e->name, "B",
+                                      buffer->thread, e->timestamp, origin, "");
+                    depth++;
+                    break;
+                case TRACE_SLICE_END:
+                case TRACE_BARRIER_EXIT:
+                    if (depth == 0)
+                        break;          // its begin event was overwritten
+                    trace_write_event(f, &first, e->kind == TRACE_BARRIER_EXIT ? "barrier" : e->name, "E",
+                                      buffer->thread, e->timestamp, origin, "");
+                    depth--;
+                    break;
+                case TRACE_REGION_EXIT:
+                    if (regions == 0)
+                        break;
+                    for (; depth > 0; depth--)          // close slices left open by a lost end event
+                        trace_write_event(f, &first, "", "E", buffer->thread, e->timestamp, origin, "");
+                    trace_write_event(f, &first, e->name, "E", buffer->thread, e->timestamp, origin, "");
+                    regions--;
+                    break;
+            }
+            if (!opens || e->kind == TRACE_REGION_ENTER)
+                idle_since = e->timestamp;
+        }
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    return 0;
+}
+
+/// Discards every recorded event
+void trace_clear(void){
+    int buffers = atomic_load(&TRACE_NUMBER_OF_BUFFERS);
+    for (int b = 0; b < buffers && b < TRACE_MAX_THREADS; b++)
+        atomic_store(&TRACE_BUFFERS[b]->head, 0);
+}
+
+#define TRACE_REGION_BEGIN(name) trace_record(TRACE_REGION_ENTER, name)
+#define TRACE_REGION_END(name) trace_record(TRACE_REGION_EXIT, name)
+#define TRACE_TASK_BEGIN(name) trace_record(TRACE_SLICE_BEGIN, name)
+#define TRACE_TASK_END(name) trace_record(TRACE_SLICE_END, name)
+#define TRACE_BARRIER_BEGIN() trace_record(TRACE_BARRIER_ENTER, "barrier")
+#define TRACE_BARRIER_END() trace_record(TRACE_BARRIER_EXIT, "barrier")
+#define TRACE_EXPORT(path) trace_export(path)
+#define TRACE_CLEAR() trace_clear()
+
+#else
+
+#define TRACE_REGION_BEGIN(name) ((void)0)
+#define TRACE_REGION_END(name) ((void)0)
+#define TRACE_TASK_BEGIN(name) ((void)0)
+#define TRACE_TASK_END(name) ((void)0)
+#define TRACE_BARRIER_BEGIN() ((void)0)
+#define TRACE_BARRIER_END() ((void)0)
+#define TRACE_EXPORT(path) ((void)0)
+#define TRACE_CLEAR() ((void)0)
+
+#endif //PARALLEL_TRACE
+
+#endif //OPENMP_C_TUTORIAL_TASK_TRACE_H